@@ -0,0 +1,70 @@
+import { APIClient, Action, Asset, Checksum256, Name, PrivateKey, Serializer, SignedTransaction, TimePointSec, Transaction, UInt64 } from "@greymass/eosio";
+
+// Benchmark `redeem` (voucher `recover_key`) against `send` on a node running `eosio.faucet` (nodeos billing, not Vert)
+//
+// NODEOS_URL    - chain API endpoint (default http://127.0.0.1:8888)
+// BENCH_ACCOUNT - account pushing the transactions (default eosio.faucet)
+// BENCH_KEY     - active private key of BENCH_ACCOUNT
+// VOUCHER_KEY   - private key matching `voucher_key` of the contract (`setvoucher`)
+// BENCH_ROUNDS  - transactions per action (default 50)
+const url = process.env.NODEOS_URL ?? "http://127.0.0.1:8888";
+const actor = process.env.BENCH_ACCOUNT ?? "eosio.faucet";
+const key = PrivateKey.from(process.env.BENCH_KEY);
+const voucher_key = PrivateKey.from(process.env.VOUCHER_KEY);
+const rounds = Number(process.env.BENCH_ROUNDS ?? 50);
+
+const client = new APIClient({ url });
+const { abi } = await client.v1.chain.get_abi("eosio.faucet");
+
+function concat(...arrays) {
+  return Uint8Array.from(arrays.flatMap(array => Array.from(array)));
+}
+
+function sign_voucher(receiver, quantity, expiry, nonce) {
+  const digest = Checksum256.hash(concat(
+    Serializer.encode({object: Name.from("eosio.faucet")}).array,
+    Serializer.encode({object: receiver, type: 'string'}).array,
+    Serializer.encode({object: Asset.from(quantity)}).array,
+    Serializer.encode({object: TimePointSec.from(expiry)}).array,
+    Serializer.encode({object: UInt64.from(nonce)}).array,
+  ));
+  return voucher_key.signDigest(digest).toString();
+}
+
+// fresh EVM receivers, `send` rate limits each receiver & EVM addresses don't require accounts
+function evm_address() {
+  return "0x" + Array.from(crypto.getRandomValues(new Uint8Array(20)), byte => byte.toString(16).padStart(2, "0")).join("");
+}
+
+async function push(name, data) {
+  const info = await client.v1.chain.get_info();
+  const action = Action.from({ account: "eosio.faucet", name, authorization: [{ actor, permission: "active" }], data }, abi);
+  const transaction = Transaction.from({ ...info.getTransactionHeader(), actions: [action] });
+  const signature = key.signDigest(transaction.signingDigest(info.chain_id));
+  const { processed } = await client.v1.chain.push_transaction(SignedTransaction.from({ ...transaction, signatures: [signature] }));
+  return { cpu: Number(processed.receipt.cpu_usage_us), elapsed: Number(processed.action_traces[0].elapsed) };
+}
+
+function report(label, samples) {
+  const stat = field => {
+    const values = samples.map(sample => sample[field]).sort((a, b) => a - b);
+    return { avg: values.reduce((a, b) => a + b, 0) / values.length, median: values[values.length >> 1] };
+  };
+  const cpu = stat("cpu"), elapsed = stat("elapsed");
+  console.log(`${label.padEnd(8)} ${samples.length} tx, cpu_usage_us avg ${cpu.avg.toFixed(0)} median ${cpu.median}, elapsed us avg ${elapsed.avg.toFixed(0)} median ${elapsed.median}`);
+  return elapsed.avg;
+}
+
+const send = [];
+for ( let i = 0; i < rounds; i++ ) send.push(await push("send", { to: evm_address() }));
+
+const redeem = [];
+const expiry = TimePointSec.fromMilliseconds(Date.now() + 3600 * 1000).toString();
+const base = Date.now();
+for ( let i = 0; i < rounds; i++ ) {
+  const receiver = evm_address(), nonce = base + i;
+  redeem.push(await push("redeem", { receiver, quantity: "0.0001 EOS", expiry, nonce, sig: sign_voucher(receiver, "0.0001 EOS", expiry, nonce) }));
+}
+
+const ratio = report("redeem", redeem) / report("send", send);
+console.log(`redeem/send elapsed ${ratio.toFixed(2)}x`);
@@ -8,20 +8,64 @@
 [[eosio::action]]
 void faucet::send( const string to )
 {
+    const config_row config = get_config();
+    const bool evm = to.length() > 12;
+    const int64_t now = current_time_point().sec_since_epoch();
+
+    // RAM pressure scales pruning and throttles admission
+    const uint32_t ram_usage = get_ram_usage();
+    const bool degraded = ram_usage >= config.ram_critical;
+    const uint32_t prune_rows = get_prune_rows( config, ram_usage );
+
+    // admission (no table writes until every check passes, rejected requests are counted in soft reject mode)
+    if ( !admit( config, !is_filtered( config, to ), "filter"_n, "eosio.faucet [address] is not allowed" ) ) return;
+    if constexpr ( !policy::EVM ) {
+        if ( !admit( config, !evm, "address"_n, "eosio.faucet [address] EVM addresses are not supported" ) ) return;
+    }
+    if ( policy::EVM && evm ) {
+        if ( !admit( config, to.substr(0, 2) == "0x", "address"_n, "eosio.faucet [address] must be a valid EVM address (missing 0x prefix)" ) ) return;
+        if ( !admit( config, to.length() == 42, "address"_n, "eosio.faucet [address] must be a valid EVM address (too short)" ) ) return;
+    } else {
+        if ( !admit( config, is_name( to ) && is_account( name{to} ), "address"_n, to + " account does not exist" ) ) return;
+    }
+    const uint64_t requests = get_stats( get_self(), 0 );
+    if ( !admit( config, requests < MAX_COUNTER_PER_GLOBAL, "globalmax"_n, "eosio.faucet has reached the global maximum allocation of tokens" ) ) return;
+
+    const ratelimit_v2_row limit = get_ratelimit( get_self(), to );
+    if ( !admit( config, !degraded || limit.last_send_time.sec_since_epoch() > 0, "degraded"_n, "eosio.faucet is low on RAM, only returning addresses are served" ) ) return;
+    if ( !admit( config, now - limit.last_send_time.sec_since_epoch() >= USER_COOLDOWN, "cooldown"_n, "eosio.faucet must wait " + to_string(USER_COOLDOWN) + " seconds" ) ) return;
+    if ( !admit( config, limit.counter < MAX_COUNTER_PER_USER, "usermax"_n, "eosio.faucet address has received the maximum allocation of tokens" ) ) return;
+
+    const asset drip = QUANTITY - (QUANTITY_DECREMENT * limit.counter);
+    if ( !admit( config, drip.amount > 0, "usermax"_n, "eosio.faucet address has reached the maximum allocation of tokens" ) ) return;
+
+    const asset balance = token::get_balance( TOKEN, get_self(), EOS.code() );
+    const asset paced = get_paced_quantity( config, drip, balance, requests );
+    const asset quantity = paced + (evm ? GAS_FEE : asset{0, EOS});
+    if ( !admit( config, balance.amount > 0 && balance >= quantity, "empty"_n, "eosio.faucet is empty, please contact administrator" ) ) return;
+    if ( !admit( config, paced.amount > 0, "paced"_n, "eosio.faucet drip is paced to zero, please try again later" ) ) return;
+
     // track history
-    add_history( to );
-    prune_history();
-    prune_rate_limits();
-    prune_rate_limit( to );
-    add_stats();
-    send_eos( to );
+    uint64_t pruned = track_history( config, to, degraded, prune_rows );
+    pruned += prune_rate_limits( get_self(), prune_rows );
+    add_stats( get_self(), MAX_COUNTER_PER_GLOBAL );
+    set_ratelimit( get_self(), limit, limit.counter + 1 );
+    send_eos( to, quantity, limit.counter + 1 );
+    add_metrics( evm ? "evm"_n : "native"_n, pruned );
 }
 
-void faucet::send_eos( const string address )
+void faucet::send_eos( const string address, const asset quantity, const uint64_t counter, const name lane )
 {
-    // send EOS tokens to EOS or EVM account
-    if ( address.length() <= 12 ) send_eos_native( address );
-    else send_eos_evm( address );
+    // send EOS tokens to EOS or EVM account (`lane` overrides the logged lane of non rate limited payouts)
+    if constexpr ( policy::EVM ) {
+        if ( address.length() > 12 ) {
+            transfer( get_self(), "eosio.evm"_n, {quantity, TOKEN}, address);
+            log_send( address, quantity, lane.value ? lane : "evm"_n, counter );
+            return;
+        }
+    }
+    transfer( get_self(), name{address}, {quantity, TOKEN}, MEMO);
+    log_send( address, quantity, lane.value ? lane : "native"_n, counter );
 }
 
 [[eosio::action]]
@@ -33,56 +77,503 @@ void faucet::nonce( const uint64_t nonce )
 [[eosio::action]]
 void faucet::create( const name account, const public_key key )
 {
+    require_auth( get_self() );
+
+    const config_row config = get_config();
+    const uint32_t ram_usage = get_ram_usage();
+    check( ram_usage < config.ram_critical, "eosio.faucet is low on RAM, account creation is paused, please try again later" );
+    add_create_ratelimit( key, get_prune_rows( config, ram_usage ) );
+
+    // send assets
+    const asset balance = token::get_balance( TOKEN, get_self(), EOS.code() );
+    check( balance >= get_create_cost( config ), "eosio.faucet is empty, please contact administrator");
+
+    create_account( account, key );
+}
+
+[[eosio::action]]
+void faucet::createsend( const name account, const public_key key )
+{
+    require_auth( get_self() );
+
+    const config_row config = get_config();
+    const string address = account.to_string();
+    check( !is_filtered( config, address ), "eosio.faucet [address] is not allowed" );
+
+    // new accounts are not admitted when low on RAM
+    const uint32_t ram_usage = get_ram_usage();
+    check( ram_usage < config.ram_critical, "eosio.faucet is low on RAM, account creation is paused, please try again later" );
+    const uint32_t prune_rows = get_prune_rows( config, ram_usage );
+    uint64_t pruned = add_create_ratelimit( key, prune_rows );
+
+    // track history
+    pruned += track_history( config, address, false, prune_rows );
+    pruned += prune_rate_limits( get_self(), prune_rows );
+
+    // pacing uses the interval counter before this request is counted, same as `send`
+    const uint64_t requests = get_stats( get_self(), 0 );
+    add_stats( get_self(), MAX_COUNTER_PER_GLOBAL );
+
+    // account is created by this action, skips `is_account` check of `send`
+    const uint64_t counter = add_ratelimit( get_self(), address, USER_COOLDOWN, MAX_COUNTER_PER_USER );
+    const asset drip = QUANTITY - (QUANTITY_DECREMENT * counter);
+    check( drip.amount > 0, "eosio.faucet address has reached the maximum allocation of tokens");
+
+    // single funding check for account creation & initial drip
+    const asset balance = token::get_balance( TOKEN, get_self(), EOS.code() );
+    const asset quantity = get_paced_quantity( config, drip, balance, requests );
+    check( balance >= get_create_cost( config ) + quantity, "eosio.faucet is empty, please contact administrator");
+    check( quantity.amount > 0, "eosio.faucet drip is paced to zero, please try again later" );
+
     create_account( account, key );
+    send_eos( address, quantity, counter + 1 );
+    add_metrics( "native"_n, pruned );
+}
+
+[[eosio::action]]
+void faucet::sethistory( const bool enabled )
+{
+    require_auth( get_self() );
+    check( policy::HISTORY || !enabled, "eosio.faucet [enabled] history is disabled by the network policy" );
+
+    faucet::config_table _config( get_self(), get_self().value );
+    auto config = _config.get_or_default();
+    config.history = enabled;
+    _config.set( config, get_self() );
+}
+
+[[eosio::action]]
+void faucet::setramcost( const asset ram_cost )
+{
+    require_auth( get_self() );
+    check( ram_cost.symbol == EOS, "eosio.faucet [ram_cost] must be EOS" );
+    check( ram_cost.amount >= 0, "eosio.faucet [ram_cost] must not be negative" );
+
+    faucet::config_table _config( get_self(), get_self().value );
+    auto config = _config.get_or_default();
+    config.ram_cost = ram_cost;
+    _config.set( config, get_self() );
+}
+
+[[eosio::action]]
+void faucet::setfilter( const name mode )
+{
+    require_auth( get_self() );
+    check( mode == name{} || mode == "deny"_n || mode == "allow"_n, "eosio.faucet [mode] must be deny, allow or empty" );
+
+    faucet::config_table _config( get_self(), get_self().value );
+    auto config = _config.get_or_default();
+    config.filter = mode;
+    _config.set( config, get_self() );
+}
+
+[[eosio::action]]
+void faucet::filteradd( const std::vector<string> addresses )
+{
+    require_auth( get_self() );
+    faucet::filter_table _filter( get_self(), get_self().value );
+
+    for ( const string& address : addresses ) {
+        const auto hash = to_checksum( to_filter_address( address ) ).extract_as_byte_array();
+        const uint64_t shard = filter_shard( hash );
+
+        auto insert = [&]( auto& row ) {
+            row.shard = shard;
+            row.bits.resize( FILTER_WORDS );
+            for ( uint32_t i = 0; i < FILTER_PROBES; i++ ) {
+                const uint32_t bit = filter_bit( hash, i );
+                row.bits[bit / 64] |= 1ULL << (bit % 64);
+            }
+        };
+        auto itr = _filter.find( shard );
+        if ( itr == _filter.end() ) _filter.emplace( get_self(), insert );
+        else _filter.modify( itr, get_self(), insert );
+    }
+}
+
+[[eosio::action]]
+void faucet::filterclear()
+{
+    require_auth( get_self() );
+    faucet::filter_table _filter( get_self(), get_self().value );
+
+    auto itr = _filter.begin();
+    while ( itr != _filter.end() ) {
+        itr = _filter.erase( itr );
+    }
+}
+
+bool faucet::is_filtered( const config_row& config, const string& address )
+{
+    if ( config.filter == "deny"_n ) return filter_contains( address );
+    if ( config.filter == "allow"_n ) return !filter_contains( address );
+    return false;
+}
+
+bool faucet::filter_contains( const string& address )
+{
+    const auto hash = to_checksum( to_filter_address( address ) ).extract_as_byte_array();
+    const uint64_t shard = filter_shard( hash );
+
+    faucet::filter_table _filter( get_self(), get_self().value );
+    auto itr = _filter.find( shard );
+    if ( itr == _filter.end() ) return false;
+
+    for ( uint32_t i = 0; i < FILTER_PROBES; i++ ) {
+        const uint32_t bit = filter_bit( hash, i );
+        if ( !((itr->bits[bit / 64] >> (bit % 64)) & 1) ) return false;
+    }
+    return true;
+}
+
+uint64_t faucet::filter_shard( const std::array<uint8_t, 32>& hash )
+{
+    return ((hash[0] << 8) | hash[1]) % FILTER_SHARDS;
+}
+
+uint32_t faucet::filter_bit( const std::array<uint8_t, 32>& hash, const uint32_t probe )
+{
+    // each probe uses the next 16 bits of the address checksum
+    return ((hash[2 + probe * 2] << 8) | hash[3 + probe * 2]) % (FILTER_WORDS * 64);
+}
+
+faucet::config_row faucet::get_config()
+{
+    faucet::config_table _config( get_self(), get_self().value );
+    return _config.get_or_default();
+}
+
+[[eosio::action]]
+void faucet::logsend( const string receiver, const asset quantity, const name lane, const uint64_t counter )
+{
+    require_auth( get_self() );
+}
+
+[[eosio::action]]
+void faucet::setround( const name round, const checksum256 root, const uint64_t leaves )
+{
+    require_auth( get_self() );
+    check( leaves > 0, "eosio.faucet [leaves] must be positive" );
+
+    // a published root is immutable, a reused round name starts from an empty bitmap
+    faucet::rounds_table _rounds( get_self(), get_self().value );
+    faucet::claimed_table _claimed( get_self(), round.value );
+    check( _rounds.find( round.value ) == _rounds.end(), "eosio.faucet [round] already exists" );
+    check( _claimed.begin() == _claimed.end(), "eosio.faucet [round] claimed bitmap is not cleared, run delround until it completes" );
+
+    _rounds.emplace( get_self(), [&]( auto& row ) {
+        row.round = round;
+        row.root = root;
+        row.leaves = leaves;
+    });
+}
+
+[[eosio::action]]
+void faucet::delround( const name round )
+{
+    require_auth( get_self() );
+
+    // round is closed first so cleared bitmap rows can't be claimed again
+    faucet::rounds_table _rounds( get_self(), get_self().value );
+    faucet::claimed_table _claimed( get_self(), round.value );
+    auto itr = _rounds.find( round.value );
+    const bool published = itr != _rounds.end();
+    check( published || _claimed.begin() != _claimed.end(), "eosio.faucet [round] does not exist" );
+    if ( published ) _rounds.erase( itr );
+
+    // bounded bitmap clear, resumed by the next call
+    uint64_t rows = 0;
+    auto claimed = _claimed.begin();
+    while ( claimed != _claimed.end() && rows < MAINTENANCE_ROWS ) {
+        claimed = _claimed.erase( claimed );
+        rows++;
+    }
+}
+
+[[eosio::action]]
+void faucet::claim( const name round, const uint64_t index, const string receiver, const asset quantity, const std::vector<checksum256> proof )
+{
+    // new bitmap rows are not written when low on RAM
+    check( get_ram_usage() < get_config().ram_critical, "eosio.faucet is low on RAM, please try again later" );
+
+    faucet::rounds_table _rounds( get_self(), get_self().value );
+    const auto& published = _rounds.get( round.value, "eosio.faucet [round] does not exist" );
+    check( index < published.leaves, "eosio.faucet [index] is out of range" );
+    check( quantity.symbol == EOS && quantity.amount > 0, "eosio.faucet [quantity] must be positive EOS" );
+    check_address( receiver );
+
+    // already claimed
+    faucet::claimed_table _claimed( get_self(), round.value );
+    const uint64_t chunk = index / (64 * CLAIM_WORDS);
+    const uint32_t word = (index / 64) % CLAIM_WORDS;
+    const uint64_t bit = 1ULL << (index % 64);
+    auto itr = _claimed.find( chunk );
+    check( itr == _claimed.end() || !(itr->bits[word] & bit), "eosio.faucet [index] has already been claimed" );
+
+    // verify Merkle proof from leaf to root
+    const std::vector<char> data = pack( std::make_tuple( index, receiver, quantity ) );
+    checksum256 node = sha256( data.data(), data.size() );
+    for ( size_t level = 0; level < proof.size(); level++ ) {
+        if ( (index >> level) & 1 ) node = hash_pair( proof[level], node );
+        else node = hash_pair( node, proof[level] );
+    }
+    check( node == published.root, "eosio.faucet [proof] is invalid" );
+
+    // send assets
+    const bool evm = receiver.length() > 12;
+    const asset amount = quantity + (evm ? GAS_FEE : asset{0, EOS});
+    const asset balance = token::get_balance( TOKEN, get_self(), EOS.code() );
+    check( balance >= amount, "eosio.faucet is empty, please contact administrator");
+
+    auto insert = [&]( auto& row ) {
+        row.chunk = chunk;
+        row.bits.resize( CLAIM_WORDS );
+        row.bits[word] |= bit;
+    };
+    if ( itr == _claimed.end() ) _claimed.emplace( get_self(), insert );
+    else _claimed.modify( itr, get_self(), insert );
+
+    send_eos( receiver, amount, 0, "claim"_n );
+    add_metrics( evm ? "evm"_n : "native"_n, 0 );
+}
+
+[[eosio::action]]
+void faucet::setvoucher( const optional<public_key> key )
+{
+    require_auth( get_self() );
+
+    faucet::config_table _config( get_self(), get_self().value );
+    auto config = _config.get_or_default();
+    config.voucher_key = key;
+    _config.set( config, get_self() );
+}
+
+[[eosio::action]]
+void faucet::redeem( const string receiver, const asset quantity, const time_point_sec expiry, const uint64_t nonce, const signature sig )
+{
+    const config_row config = get_config();
+    const int64_t now = current_time_point().sec_since_epoch();
+    check( config.voucher_key.has_value(), "eosio.faucet vouchers are disabled" );
+    check( get_ram_usage() < config.ram_critical, "eosio.faucet is low on RAM, please try again later" );
+    check( expiry.sec_since_epoch() > now, "eosio.faucet [expiry] voucher has expired" );
+    check( expiry.sec_since_epoch() <= now + MAX_VOUCHER_TTL, "eosio.faucet [expiry] exceeds maximum voucher TTL" );
+    check( quantity.symbol == EOS && quantity.amount > 0, "eosio.faucet [quantity] must be positive EOS" );
+    check_address( receiver );
+
+    // verify voucher signature
+    const std::vector<char> data = pack( std::make_tuple( get_self(), receiver, quantity, expiry, nonce ) );
+    const checksum256 digest = sha256( data.data(), data.size() );
+    check( recover_key( digest, sig ) == *config.voucher_key, "eosio.faucet [sig] invalid voucher signature" );
+
+    // single use nonce, bitmap of the voucher expiry bucket
+    const uint64_t bucket = expiry.sec_since_epoch() / NONCE_PERIOD;
+    const uint64_t chunk = nonce / (64 * NONCE_WORDS);
+    const uint32_t word = (nonce / 64) % NONCE_WORDS;
+    const uint64_t bit = 1ULL << (nonce % 64);
+    faucet::nonces_table _nonces( get_self(), bucket );
+    auto itr = _nonces.find( chunk );
+    check( itr == _nonces.end() || !(itr->bits[word] & bit), "eosio.faucet [nonce] voucher has already been redeemed" );
+
+    auto insert = [&]( auto& row ) {
+        row.chunk = chunk;
+        row.bits.resize( NONCE_WORDS );
+        row.bits[word] |= bit;
+    };
+    if ( itr == _nonces.end() ) {
+        _nonces.emplace( get_self(), insert );
+        faucet::nonce_buckets_table _buckets( get_self(), get_self().value );
+        if ( _buckets.find( bucket ) == _buckets.end() ) _buckets.emplace( get_self(), [&]( auto& row ) { row.bucket = bucket; });
+    }
+    else _nonces.modify( itr, get_self(), insert );
+    const uint64_t pruned = prune_nonces();
+
+    // send assets
+    const bool evm = receiver.length() > 12;
+    const asset amount = quantity + (evm ? GAS_FEE : asset{0, EOS});
+    const asset balance = token::get_balance( TOKEN, get_self(), EOS.code() );
+    check( balance >= amount, "eosio.faucet is empty, please contact administrator");
+    send_eos( receiver, amount, 0, "redeem"_n );
+    add_metrics( evm ? "evm"_n : "native"_n, 0, pruned );
+}
+
+uint64_t faucet::prune_nonces()
+{
+    // buckets are dropped once every voucher of the bucket has expired
+    faucet::nonce_buckets_table _buckets( get_self(), get_self().value );
+    const uint64_t now = current_time_point().sec_since_epoch();
+    uint32_t count = 0;
+    auto bucket = _buckets.begin();
+    while ( bucket != _buckets.end() && (bucket->bucket + 1) * NONCE_PERIOD <= now && count < PRUNE_ROWS ) {
+        faucet::nonces_table _nonces( get_self(), bucket->bucket );
+        auto itr = _nonces.begin();
+        while ( itr != _nonces.end() && count < PRUNE_ROWS ) {
+            itr = _nonces.erase( itr );
+            count++;
+        }
+        if ( itr != _nonces.end() ) break;
+        bucket = _buckets.erase( bucket );
+    }
+    return count;
+}
+
+void faucet::check_address( const string& address )
+{
+    if ( address.length() <= 12 ) {
+        check( is_name( address ) && is_account( name{address} ), address + " account does not exist" );
+        return;
+    }
+    check( policy::EVM, "eosio.faucet [address] EVM addresses are not supported" );
+    check( address.substr(0, 2) == "0x", "eosio.faucet [address] must be a valid EVM address (missing 0x prefix)" );
+    check( address.length() == 42, "eosio.faucet [address] must be a valid EVM address (too short)" );
+}
+
+checksum256 faucet::hash_pair( const checksum256& left, const checksum256& right )
+{
+    const auto l = left.extract_as_byte_array();
+    const auto r = right.extract_as_byte_array();
+    char data[64];
+    std::copy( l.begin(), l.end(), data );
+    std::copy( r.begin(), r.end(), data + 32 );
+    return sha256( data, 64 );
+}
+
+faucet::schema_row faucet::get_schema()
+{
+    // cached, the hot path pays a single version check per action
+    if ( !_schema ) {
+        faucet::schema_table _table( get_self(), get_self().value );
+        _schema = _table.get_or_default();
+    }
+    return *_schema;
+}
+
+[[eosio::action]]
+faucet::migrate_result faucet::migrate( const uint64_t max_rows )
+{
+    require_auth( get_self() );
+    faucet::schema_table _table( get_self(), get_self().value );
+    schema_row schema = _table.get_or_default();
+    uint64_t rows = max_rows == 0 ? MAINTENANCE_ROWS : max_rows;
+    const uint64_t budget = rows;
+
+    // start migration, rows are written to the new layout from now on
+    if ( schema.version < SCHEMA_VERSION ) {
+        schema.version = SCHEMA_VERSION;
+        schema.migrating = true;
+    }
+    if ( schema.migrating ) {
+        bool done = true;
+        for ( const name scope : { get_self(), CREATE_SCOPE } ) {
+            if ( !migrate_ratelimits( scope, rows ) ) done = false;
+        }
+        schema.migrating = !done;
+    }
+    _table.set( schema, get_self() );
+    return { schema.version, budget - rows, !schema.migrating };
+}
+
+bool faucet::migrate_ratelimits( const name scope, uint64_t& max_rows )
+{
+    faucet::ratelimit_table legacy( get_self(), scope.value );
+    faucet::ratelimit_v2_table ratelimit( get_self(), scope.value );
+    const int64_t now = current_time_point().sec_since_epoch();
+
+    auto itr = legacy.begin();
+    while ( itr != legacy.end() && max_rows ) {
+        // expired rows are dropped instead of migrated
+        if ( itr->last_send_time.sec_since_epoch() >= (now - TTL_USER_RATE_LIMIT) ) migrate_ratelimit( ratelimit, *itr );
+        itr = legacy.erase( itr );
+        max_rows--;
+    }
+    return itr == legacy.end();
+}
+
+void faucet::migrate_ratelimit( ratelimit_v2_table& ratelimit, const ratelimit_row& row )
+{
+    // rows already written with the new layout take precedence,
+    // legacy rows without a free key are dropped (same as an expired rate limit)
+    const optional<ratelimit_v2_row> slot = find_ratelimit( ratelimit, row.address );
+    if ( !slot || slot->last_send_time.sec_since_epoch() > 0 ) return;
+
+    ratelimit.emplace( get_self(), [&]( auto& v2 ) {
+        v2.key = slot->key;
+        v2.address = row.address;
+        v2.counter = row.counter;
+        v2.last_send_time = row.last_send_time;
+    });
 }
 
 [[eosio::action]]
 void faucet::test( const string address )
 {
     require_auth( get_self() );
-    send_eos( address );
-    // prune_history();
-    // prune_rate_limit(address);
-    // prune_rate_limits();
-    // add_ratelimit(address);
+
+    // rate limited send, without `history`, `stats`, metrics or `logsend`
+    check_address( address );
+    const bool evm = address.length() > 12;
+    const uint64_t counter = add_ratelimit( get_self(), address, USER_COOLDOWN, MAX_COUNTER_PER_USER );
+    const asset drip = QUANTITY - (QUANTITY_DECREMENT * counter);
+    check( drip.amount > 0, "eosio.faucet address has reached the maximum allocation of tokens");
+
+    const asset quantity = drip + (evm ? GAS_FEE : asset{0, EOS});
+    const asset balance = token::get_balance( TOKEN, get_self(), EOS.code() );
+    check( balance >= quantity, "eosio.faucet is empty, please contact administrator");
+    if ( evm ) transfer( get_self(), "eosio.evm"_n, {quantity, TOKEN}, address );
+    else transfer( get_self(), name{address}, {quantity, TOKEN}, MEMO );
+}
+
+uint64_t faucet::track_history( const config_row& config, const string& address, const bool degraded, const uint32_t prune_rows )
+{
+    if constexpr ( policy::HISTORY ) {
+        if ( config.history && !degraded ) add_history( address );
+        return prune_history( config.history, prune_rows );
+    } else {
+        // drain rows written before the policy disabled history
+        return prune_history( false, prune_rows );
+    }
 }
 
-void faucet::prune_history()
+uint64_t faucet::prune_history( const bool enabled, const uint32_t max_rows )
 {
     faucet::history_table history( get_self(), get_self().value );
-    int count = 0;
+    uint32_t count = 0;
     while ( history.begin() != history.end() ) {
         const auto& row = history.begin();
         const int64_t now = current_time_point().sec_since_epoch();
         const int64_t timestamp = row->timestamp.sec_since_epoch();
-        if ( timestamp < (now - TTL_HISTORY) ) {
+        // drain all rows when history is disabled
+        if ( !enabled || timestamp < (now - TTL_HISTORY) ) {
             history.erase( row );
         } else {
             break;
         }
         count++;
-        if ( count >= 10 ) break;
+        if ( count >= max_rows ) break;
     }
+    return count;
 }
 
-void faucet::prune_rate_limit( const string address )
+uint64_t faucet::prune_rate_limits( const name scope, const uint32_t max_rows )
 {
-    faucet::ratelimit_table _ratelimit( get_self(), get_self().value );
-    auto idx = _ratelimit.get_index<"by.address"_n>();
-    auto it = idx.find(to_checksum(address));
-    if ( !it->address.length() ) return;
-
-    const int64_t now = current_time_point().sec_since_epoch();
-    const int64_t timestamp = it->last_send_time.sec_since_epoch();
-    if ( timestamp < (now - TTL_USER_RATE_LIMIT) ) {
-        idx.erase( it );
+    const schema_row schema = get_schema();
+    uint32_t count = 0;
+    if ( schema.version >= SCHEMA_VERSION ) {
+        faucet::ratelimit_v2_table ratelimit( get_self(), scope.value );
+        auto idx = ratelimit.get_index<"by.time"_n>();
+        const int64_t now = current_time_point().sec_since_epoch();
+        while ( idx.begin() != idx.end() ) {
+            const auto row = idx.begin();
+            if ( row->last_send_time.sec_since_epoch() >= (now - TTL_USER_RATE_LIMIT) ) break;
+            idx.erase( row );
+            count++;
+            if ( count >= max_rows ) break;
+        }
+        // legacy rows are pruned until migrated
+        if ( !schema.migrating ) return count;
     }
-}
 
-void faucet::prune_rate_limits()
-{
-    faucet::ratelimit_table ratelimit( get_self(), get_self().value );
-    int count = 0;
+    faucet::ratelimit_table ratelimit( get_self(), scope.value );
+    const uint32_t limit = count + max_rows;
     while ( ratelimit.begin() != ratelimit.end() ) {
         const auto& row = ratelimit.begin();
         const int64_t now = current_time_point().sec_since_epoch();
@@ -93,8 +584,9 @@ void faucet::prune_rate_limits()
             break;
         }
         count++;
-        if ( count >= 10 ) break;
+        if ( count >= limit ) break;
     }
+    return count;
 }
 
 void faucet::add_history( const string address )
@@ -108,101 +600,463 @@ void faucet::add_history( const string address )
     history.emplace( get_self(), insert );
 }
 
-void faucet::add_stats()
+void faucet::add_stats( const name scope, const uint64_t max_counter )
 {
-    faucet::stats_table stats( get_self(), get_self().value );
+    faucet::stats_table stats( get_self(), scope.value );
     const int64_t current = (current_time_point().sec_since_epoch() / STATS_INTERVAL) * STATS_INTERVAL;
     auto insert = [&]( auto& row ) {
         row.timestamp = time_point_sec(current);
         row.counter += 1;
-        check( row.counter <= MAX_COUNTER_PER_GLOBAL, "eosio.faucet has reached the global maximum allocation of tokens");
+        check( row.counter <= max_counter, "eosio.faucet has reached the global maximum allocation of tokens");
     };
     auto itr = stats.find( current );
     if ( itr == stats.end() ) stats.emplace( get_self(), insert );
     else stats.modify( itr, get_self(), insert );
 }
 
-uint64_t faucet::add_ratelimit( const string address )
+uint64_t faucet::get_stats( const name scope, const uint32_t intervals_ago )
 {
-    faucet::ratelimit_table _ratelimit( get_self(), get_self().value );
-    auto idx = _ratelimit.get_index<"by.address"_n>();
-    auto it = idx.find(to_checksum(address));
+    faucet::stats_table stats( get_self(), scope.value );
+    const int64_t current = (current_time_point().sec_since_epoch() / STATS_INTERVAL - intervals_ago) * STATS_INTERVAL;
+    auto itr = stats.find( current );
+    return itr == stats.end() ? 0 : itr->counter;
+}
+
+uint64_t faucet::add_ratelimit( const name scope, const string address, const uint32_t cooldown, const uint64_t max_counter )
+{
+    const ratelimit_v2_row limit = get_ratelimit( scope, address );
+    const int64_t now = current_time_point().sec_since_epoch();
+    check(now - limit.last_send_time.sec_since_epoch() >= cooldown, "eosio.faucet must wait " + to_string(cooldown) + " seconds");
+    check(limit.counter < max_counter, "eosio.faucet address has received the maximum allocation of tokens");
 
     // previous counter used for decrementing quantity
-    const uint64_t previous_counter = it->counter;
+    set_ratelimit( scope, limit, limit.counter + 1 );
+    return limit.counter;
+}
 
-    auto insert = [&]( auto& row ) {
-        const int64_t now = current_time_point().sec_since_epoch();
-        const int64_t last = row.last_send_time.sec_since_epoch();
-        const int64_t diff = now - last;
-        check(diff >= USER_COOLDOWN, "eosio.faucet must wait " + to_string(USER_COOLDOWN) + " seconds");
-        check(row.counter < MAX_COUNTER_PER_USER, "eosio.faucet address has received the maximum allocation of tokens");
+optional<faucet::ratelimit_v2_row> faucet::find_ratelimit( const ratelimit_v2_table& ratelimit, const string& address )
+{
+    // row of `address` within the probed keys, otherwise the first free key (empty `last_send_time`)
+    const uint64_t key = to_key( address );
+    optional<ratelimit_v2_row> slot;
+    uint64_t next = key;
+    for ( auto itr = ratelimit.lower_bound( key ); itr != ratelimit.end() && itr->key - key < RATELIMIT_PROBES; ++itr ) {
+        if ( itr->address == address ) return *itr;
+        if ( !slot && itr->key != next ) slot = ratelimit_v2_row{ next, address };
+        next = itr->key + 1;
+    }
+    if ( !slot && next - key < RATELIMIT_PROBES ) slot = ratelimit_v2_row{ next, address };
+    return slot;
+}
+
+faucet::ratelimit_v2_row faucet::get_ratelimit( const name scope, const string& address )
+{
+    const schema_row schema = get_schema();
+    ratelimit_v2_row limit = { to_key( address ), address };
+    bool found = false;
+
+    if ( schema.version >= SCHEMA_VERSION ) {
+        faucet::ratelimit_v2_table _ratelimit( get_self(), scope.value );
+        const optional<ratelimit_v2_row> slot = find_ratelimit( _ratelimit, address );
+        check( slot.has_value(), "eosio.faucet [address] rate limit keys are exhausted, please try again later" );
+        limit = *slot;
+        found = limit.last_send_time.sec_since_epoch() > 0;
+    }
+    // legacy layout (or fallback to legacy row during migration), the row is only moved by `set_ratelimit`
+    if ( !found && (schema.version < SCHEMA_VERSION || schema.migrating) ) {
+        faucet::ratelimit_table legacy( get_self(), scope.value );
+        auto idx = legacy.get_index<"by.address"_n>();
+        auto itr = idx.find( to_checksum( address ) );
+        if ( itr != idx.end() ) {
+            limit.counter = itr->counter;
+            limit.last_send_time = itr->last_send_time;
+        }
+    }
+
+    // expired rate limits restart from zero
+    const int64_t now = current_time_point().sec_since_epoch();
+    if ( limit.last_send_time.sec_since_epoch() < (now - TTL_USER_RATE_LIMIT) ) limit.counter = 0;
+    return limit;
+}
 
-        if (it == idx.end() ) row.id = _ratelimit.available_primary_key();
+void faucet::set_ratelimit( const name scope, const ratelimit_v2_row& limit, const uint64_t counter )
+{
+    const schema_row schema = get_schema();
+    const string& address = limit.address;
+
+    if ( schema.version >= SCHEMA_VERSION ) {
+        // `limit.key` is the key resolved by `get_ratelimit` (address row or free key)
+        faucet::ratelimit_v2_table _ratelimit( get_self(), scope.value );
+        auto itr = _ratelimit.find( limit.key );
+        check( itr == _ratelimit.end() || itr->address == address, "eosio.faucet [address] rate limit key is used by another address" );
+
+        // legacy row is replaced by the new layout on first write during migration
+        if ( itr == _ratelimit.end() && schema.migrating ) {
+            faucet::ratelimit_table legacy( get_self(), scope.value );
+            auto idx = legacy.get_index<"by.address"_n>();
+            auto legacy_itr = idx.find( to_checksum( address ) );
+            if ( legacy_itr != idx.end() ) idx.erase( legacy_itr );
+        }
+
+        auto insert = [&]( auto& row ) {
+            row.key = limit.key;
+            row.address = address;
+            row.counter = counter;
+            row.last_send_time = current_time_point();
+        };
+        if ( itr == _ratelimit.end() ) _ratelimit.emplace( get_self(), insert );
+        else _ratelimit.modify( itr, get_self(), insert );
+        return;
+    }
+
+    faucet::ratelimit_table _ratelimit( get_self(), scope.value );
+    auto idx = _ratelimit.get_index<"by.address"_n>();
+    auto it = idx.find( to_checksum( address ) );
+    auto insert = [&]( auto& row ) {
+        if ( it == idx.end() ) row.id = _ratelimit.available_primary_key();
         row.address = address;
-        row.counter += 1;
+        row.counter = counter;
         row.last_send_time = current_time_point();
     };
-    auto itr = _ratelimit.find( it->id );
     if ( it == idx.end() ) _ratelimit.emplace( get_self(), insert );
-    else _ratelimit.modify( itr, get_self(), insert );
-    return previous_counter;
+    else _ratelimit.modify( _ratelimit.find( it->id ), get_self(), insert );
 }
 
-void faucet::send_eos_evm( const string address )
+asset faucet::get_paced_quantity( const config_row& config, const asset quantity, const asset balance, const uint64_t requests )
 {
-    const uint64_t counter = add_ratelimit( address );
-    const asset quantity = QUANTITY - (QUANTITY_DECREMENT * counter) + GAS_FEE;
-    const asset balance = token::get_balance( TOKEN, get_self(), EOS.code() );
+    if ( !config.refill_period ) return quantity;
 
-    // user rate limit
-    check( quantity.amount > 0, "eosio.faucet address has reached the maximum allocation of tokens");
-    check( address.substr(0, 2) == "0x", "eosio.faucet [address] must be a valid EVM address (missing 0x prefix)");
-    check( address.length() == 42, "eosio.faucet [address] must be a valid EVM address (too short)");
-    check( balance >= quantity, "eosio.faucet is empty, please contact administrator");
-    transfer( get_self(), "eosio.evm"_n, {quantity, TOKEN}, address);
+    // seconds & stats intervals remaining until the next refill
+    const int64_t now = current_time_point().sec_since_epoch();
+    const int64_t epoch = config.refill_epoch.sec_since_epoch();
+    const int64_t elapsed = now > epoch ? (now - epoch) % config.refill_period : 0;
+    const int64_t intervals = std::max<int64_t>( 1, (config.refill_period - elapsed + STATS_INTERVAL - 1) / STATS_INTERVAL );
+
+    // spend remaining balance evenly per interval, shared by recent demand (previous or current interval)
+    const uint64_t demand = std::max<uint64_t>({ 1, requests, get_stats( get_self(), 1 ) });
+    const int64_t budget = balance.amount / intervals / demand;
+
+    // 16.16 fixed-point scale applied to the drip (never above the configured amount)
+    const int64_t scale = std::min<int64_t>( PACING_ONE, (budget * PACING_ONE) / QUANTITY.amount );
+    return asset{ (quantity.amount * scale) / PACING_ONE, EOS };
 }
 
-void faucet::send_eos_native( const string address )
+uint32_t faucet::get_ram_usage()
 {
-    const uint64_t counter = add_ratelimit( address );
-    const name account = name{address};
-    check( is_account( account ), account.to_string() + " account does not exist" );
+    // RAM usage in percent of quota, stale or missing reports are ignored
+    faucet::watchdog_table _watchdog( get_self(), get_self().value );
+    const watchdog_row watchdog = _watchdog.get_or_default();
+    const int64_t now = current_time_point().sec_since_epoch();
+    if ( watchdog.ram_quota <= 0 || watchdog.updated.sec_since_epoch() < (now - WATCHDOG_TTL) ) return 0;
+    return watchdog.ram_usage * 100 / watchdog.ram_quota;
+}
 
-    // send assets
-    const asset balance = token::get_balance( TOKEN, get_self(), EOS.code() );
-    const asset quantity = QUANTITY - (QUANTITY_DECREMENT * counter);
-    check( quantity.amount > 0, "eosio.faucet address has reached the maximum allocation of tokens");
-    check( balance >= quantity, "eosio.faucet is empty, please contact administrator");
-    transfer( get_self(), account, {quantity, TOKEN}, MEMO);
+uint32_t faucet::get_prune_rows( const config_row& config, const uint32_t ram_usage )
+{
+    // pruning budget grows by PRUNE_ROWS per percent above the high watermark
+    if ( ram_usage < config.ram_high ) return PRUNE_ROWS;
+    return std::min<uint32_t>( MAX_PRUNE_ROWS, PRUNE_ROWS * (1 + ram_usage - config.ram_high) );
+}
+
+[[eosio::action]]
+void faucet::ramreport( const int64_t ram_usage, const int64_t ram_quota )
+{
+    require_auth( get_self() );
+    check( ram_usage >= 0 && ram_quota > 0, "eosio.faucet [ram_quota] must be positive" );
+
+    faucet::watchdog_table _watchdog( get_self(), get_self().value );
+    _watchdog.set( watchdog_row{ ram_usage, ram_quota, current_time_point() }, get_self() );
+}
+
+[[eosio::action]]
+void faucet::setwatermark( const uint8_t ram_high, const uint8_t ram_critical )
+{
+    require_auth( get_self() );
+    check( ram_critical > 0 && ram_critical <= 100, "eosio.faucet [ram_critical] must be between 1 and 100" );
+    check( ram_high <= ram_critical, "eosio.faucet [ram_high] must not exceed [ram_critical]" );
+
+    faucet::config_table _config( get_self(), get_self().value );
+    auto config = _config.get_or_default();
+    config.ram_high = ram_high;
+    config.ram_critical = ram_critical;
+    _config.set( config, get_self() );
+}
+
+bool faucet::admit( const config_row& config, const bool condition, const name reason, const string& message )
+{
+    if ( condition ) return true;
+
+    // soft reject: count the rejection and complete the transaction without sending tokens
+    check( config.soft_reject, message );
+    faucet::metrics_table _metrics( get_self(), get_self().value );
+    auto metrics = _metrics.get_or_default();
+    if ( reason == "filter"_n ) metrics.rejected_filter++;
+    else if ( reason == "address"_n ) metrics.rejected_address++;
+    else if ( reason == "globalmax"_n ) metrics.rejected_global_max++;
+    else if ( reason == "cooldown"_n ) metrics.rejected_cooldown++;
+    else if ( reason == "usermax"_n ) metrics.rejected_user_max++;
+    else if ( reason == "empty"_n ) metrics.rejected_empty++;
+    else if ( reason == "degraded"_n ) metrics.rejected_degraded++;
+    else if ( reason == "paced"_n ) metrics.rejected_paced++;
+    _metrics.set( metrics, get_self() );
+    return false;
+}
+
+void faucet::add_metrics( const name lane, const uint64_t pruned, const uint64_t pruned_nonces )
+{
+    faucet::metrics_table _metrics( get_self(), get_self().value );
+    auto metrics = _metrics.get_or_default();
+    if ( lane == "evm"_n ) metrics.sends_evm++;
+    else metrics.sends_native++;
+    metrics.pruned += pruned;
+    metrics.pruned_nonces += pruned_nonces;
+    _metrics.set( metrics, get_self() );
+}
+
+[[eosio::action, eosio::read_only]]
+faucet::metrics_row faucet::getmetrics()
+{
+    faucet::metrics_table _metrics( get_self(), get_self().value );
+    return _metrics.get_or_default();
+}
+
+[[eosio::action]]
+void faucet::setpacing( const uint32_t refill_period, const time_point_sec refill_epoch )
+{
+    require_auth( get_self() );
+
+    faucet::config_table _config( get_self(), get_self().value );
+    auto config = _config.get_or_default();
+    config.refill_period = refill_period;
+    config.refill_epoch = refill_epoch;
+    _config.set( config, get_self() );
+}
+
+[[eosio::action]]
+void faucet::setsoftrej( const bool enabled )
+{
+    require_auth( get_self() );
+
+    faucet::config_table _config( get_self(), get_self().value );
+    auto config = _config.get_or_default();
+    config.soft_reject = enabled;
+    _config.set( config, get_self() );
+}
+
+template <typename T, typename F>
+bool faucet::erase_rows( T& table, cursor_row& cursor, uint64_t max_rows, F predicate )
+{
+    auto itr = table.lower_bound( cursor.next );
+    while ( itr != table.end() && max_rows-- ) {
+        cursor.scanned++;
+        if ( predicate( *itr ) ) {
+            itr = table.erase( itr );
+            cursor.erased++;
+        } else {
+            itr++;
+        }
+    }
+    if ( itr == table.end() ) return true;
+    cursor.next = itr->primary_key();
+    return false;
 }
 
-// @debug
-template <typename T>
-void faucet::clear_table( T& table, uint64_t rows_to_clear )
+bool faucet::compact_stats( stats_table& stats, stats_daily_table& daily, cursor_row& cursor, uint64_t max_rows )
 {
-    auto itr = table.begin();
-    while ( itr != table.end() && rows_to_clear-- ) {
-        itr = table.erase( itr );
+    const int64_t now = current_time_point().sec_since_epoch();
+    auto itr = stats.lower_bound( cursor.next );
+    while ( itr != stats.end() && max_rows-- ) {
+        cursor.scanned++;
+        const int64_t timestamp = itr->timestamp.sec_since_epoch();
+
+        // stats are ordered by timestamp, remaining rows are recent
+        if ( timestamp >= (now - TTL_HISTORY) ) return true;
+
+        // daily totals are kept apart from hourly rows
+        const int64_t day = (timestamp / COMPACT_INTERVAL) * COMPACT_INTERVAL;
+        const uint64_t counter = itr->counter;
+        itr = stats.erase( itr );
+        cursor.erased++;
+
+        auto insert = [&]( auto& row ) {
+            row.timestamp = time_point_sec(day);
+            row.counter += counter;
+        };
+        auto day_itr = daily.find( day );
+        if ( day_itr == daily.end() ) daily.emplace( get_self(), insert );
+        else daily.modify( day_itr, get_self(), insert );
     }
+    if ( itr == stats.end() ) return true;
+    cursor.next = itr->primary_key();
+    return false;
 }
 
-// @[[eosio::action]]debug
-void faucet::cleartable( const name table_name, const optional<name> scope, const optional<uint64_t> max_rows )
+[[eosio::action]]
+faucet::maintain_result faucet::maintain( const name table_name, const name op, const optional<name> scope, const optional<string> prefix, const optional<uint64_t> max_rows )
 {
     require_auth( get_self() );
-    const uint64_t rows_to_clear = (!max_rows || *max_rows == 0) ? -1 : *max_rows;
+    const name table_scope = scope ? *scope : get_self();
+    const string match = prefix ? *prefix : "";
+    const uint64_t rows = (!max_rows || *max_rows == 0) ? MAINTENANCE_ROWS : *max_rows;
+    check( op != "prefix"_n || match.length(), "eosio.faucet [prefix] is required by prefix operation" );
+
+    // resume from persisted cursor (restarts when a different operation is requested)
+    faucet::cursor_table _cursor( get_self(), table_name.value );
+    auto itr = _cursor.find( table_scope.value );
+    cursor_row cursor = { table_scope, op, match };
+    if ( itr != _cursor.end() && itr->op == op && itr->prefix == match ) cursor = *itr;
+
+    const int64_t now = current_time_point().sec_since_epoch();
+    auto all = []( const auto& row ) { return true; };
+    auto is_prefixed = [&]( const string& address ) { return address.substr(0, match.length()) == match; };
+    bool done = false;
+
+    if ( table_name == "ratelimit"_n ) {
+        faucet::ratelimit_table _ratelimit( get_self(), table_scope.value );
+        if ( op == "all"_n ) done = erase_rows( _ratelimit, cursor, rows, all );
+        else if ( op == "expired"_n ) done = erase_rows( _ratelimit, cursor, rows, [&]( const auto& row ) {
+            return row.last_send_time.sec_since_epoch() < (now - TTL_USER_RATE_LIMIT);
+        });
+        else if ( op == "prefix"_n ) done = erase_rows( _ratelimit, cursor, rows, [&]( const auto& row ) {
+            return is_prefixed( row.address );
+        });
+        else check(false, "eosio.faucet [op] unknown operation for ratelimit table" );
+    }
+    else if ( table_name == "ratelimit.v2"_n ) {
+        faucet::ratelimit_v2_table _ratelimit( get_self(), table_scope.value );
+        if ( op == "all"_n ) done = erase_rows( _ratelimit, cursor, rows, all );
+        else if ( op == "expired"_n ) done = erase_rows( _ratelimit, cursor, rows, [&]( const auto& row ) {
+            return row.last_send_time.sec_since_epoch() < (now - TTL_USER_RATE_LIMIT);
+        });
+        else if ( op == "prefix"_n ) done = erase_rows( _ratelimit, cursor, rows, [&]( const auto& row ) {
+            return is_prefixed( row.address );
+        });
+        else check(false, "eosio.faucet [op] unknown operation for ratelimit.v2 table" );
+    }
+    else if ( table_name == "history"_n ) {
+        faucet::history_table _history( get_self(), table_scope.value );
+        if ( op == "all"_n ) done = erase_rows( _history, cursor, rows, all );
+        else if ( op == "expired"_n ) done = erase_rows( _history, cursor, rows, [&]( const auto& row ) {
+            return row.timestamp.sec_since_epoch() < (now - TTL_HISTORY);
+        });
+        else if ( op == "prefix"_n ) done = erase_rows( _history, cursor, rows, [&]( const auto& row ) {
+            return is_prefixed( row.receiver );
+        });
+        else check(false, "eosio.faucet [op] unknown operation for history table" );
+    }
+    else if ( table_name == "stats"_n ) {
+        faucet::stats_table _stats( get_self(), table_scope.value );
+        if ( op == "all"_n ) done = erase_rows( _stats, cursor, rows, all );
+        else if ( op == "expired"_n ) done = erase_rows( _stats, cursor, rows, [&]( const auto& row ) {
+            return row.timestamp.sec_since_epoch() < (now - TTL_HISTORY);
+        });
+        else if ( op == "compact"_n ) {
+            faucet::stats_daily_table _daily( get_self(), table_scope.value );
+            done = compact_stats( _stats, _daily, cursor, rows );
+        }
+        else check(false, "eosio.faucet [op] unknown operation for stats table" );
+    }
+    else if ( table_name == "stats.daily"_n ) {
+        faucet::stats_daily_table _daily( get_self(), table_scope.value );
+        if ( op == "all"_n ) done = erase_rows( _daily, cursor, rows, all );
+        else check(false, "eosio.faucet [op] unknown operation for stats.daily table" );
+    }
+    else if ( table_name == "claimed"_n ) {
+        faucet::claimed_table _claimed( get_self(), table_scope.value );
+        if ( op == "all"_n ) done = erase_rows( _claimed, cursor, rows, all );
+        else check(false, "eosio.faucet [op] unknown operation for claimed table" );
+    }
+    else check(false, "eosio.faucet [table_name] unknown table to maintain" );
+
+    // persist progress
+    if ( done ) {
+        if ( itr != _cursor.end() ) _cursor.erase( itr );
+    }
+    else if ( itr == _cursor.end() ) _cursor.emplace( get_self(), [&]( auto& row ) { row = cursor; });
+    else _cursor.modify( itr, get_self(), [&]( auto& row ) { row = cursor; });
+
+    return { cursor.op, cursor.next, cursor.scanned, cursor.erased, done };
+}
+
+template <typename T, typename F, typename P>
+faucet::export_result faucet::export_rows( const T& table, const uint64_t cursor, const uint32_t limit, F in_range, P is_past )
+{
+    export_result result = { {}, cursor, 0, false };
+    auto itr = table.lower_bound( cursor );
+    uint32_t scanned = 0;
+    while ( itr != table.end() && scanned < limit ) {
+        // ordered by timestamp, remaining rows are past the time range
+        if ( is_past( *itr ) ) return result;
+        if ( in_range( *itr ) ) {
+            const std::vector<char> row = pack( *itr );
+            result.rows.insert( result.rows.end(), row.begin(), row.end() );
+            result.count++;
+        }
+        scanned++;
+        itr++;
+    }
+    result.more = itr != table.end();
+    if ( result.more ) result.cursor = itr->primary_key();
+    return result;
+}
+
+[[eosio::action, eosio::read_only]]
+faucet::export_result faucet::exportrows( const name table_name, const optional<name> scope, const uint64_t cursor, const optional<time_point_sec> from, const optional<time_point_sec> to, const uint32_t limit )
+{
     const uint64_t value = scope ? scope->value : get_self().value;
+    const uint32_t rows = (limit == 0 || limit > EXPORT_ROWS) ? EXPORT_ROWS : limit;
+    const uint32_t lower = from ? from->sec_since_epoch() : 0;
+    const uint32_t upper = to ? to->sec_since_epoch() : UINT32_MAX;
+
+    auto in_range = [&]( const time_point_sec timestamp ) {
+        return timestamp.sec_since_epoch() >= lower && timestamp.sec_since_epoch() <= upper;
+    };
+    auto never = []( const auto& row ) { return false; };
 
-    // tables
-    faucet::ratelimit_table _ratelimit( get_self(), value );
-    faucet::history_table _history( get_self(), value );
-    faucet::stats_table _stats( get_self(), value );
+    if ( table_name == "ratelimit"_n ) {
+        faucet::ratelimit_table _ratelimit( get_self(), value );
+        return export_rows( _ratelimit, cursor, rows, [&]( const auto& row ) { return in_range( row.last_send_time ); }, never );
+    }
+    if ( table_name == "ratelimit.v2"_n ) {
+        faucet::ratelimit_v2_table _ratelimit( get_self(), value );
+        return export_rows( _ratelimit, cursor, rows, [&]( const auto& row ) { return in_range( row.last_send_time ); }, never );
+    }
+    if ( table_name == "history"_n ) {
+        faucet::history_table _history( get_self(), value );
+        return export_rows( _history, std::max<uint64_t>( cursor, seek_history( _history, lower ) ), rows, [&]( const auto& row ) { return in_range( row.timestamp ); }, [&]( const auto& row ) {
+            return row.timestamp.sec_since_epoch() > upper;
+        });
+    }
+    if ( table_name == "stats"_n ) {
+        // stats primary key is the timestamp, seek directly to the start of the time range
+        faucet::stats_table _stats( get_self(), value );
+        return export_rows( _stats, std::max<uint64_t>( cursor, lower ), rows, [&]( const auto& row ) { return in_range( row.timestamp ); }, [&]( const auto& row ) {
+            return row.timestamp.sec_since_epoch() > upper;
+        });
+    }
+    if ( table_name == "stats.daily"_n ) {
+        faucet::stats_daily_table _daily( get_self(), value );
+        return export_rows( _daily, std::max<uint64_t>( cursor, lower ), rows, [&]( const auto& row ) { return in_range( row.timestamp ); }, [&]( const auto& row ) {
+            return row.timestamp.sec_since_epoch() > upper;
+        });
+    }
+    check(false, "eosio.faucet [table_name] unknown table to export" );
+    return {};
+}
 
-    if (table_name == "ratelimit"_n) clear_table( _ratelimit, rows_to_clear );
-    else if (table_name == "history"_n) clear_table( _history, rows_to_clear );
-    else if (table_name == "stats"_n) clear_table( _stats, rows_to_clear );
-    else check(false, "eosio.faucet [table_name] unknown table to clear" );
+uint64_t faucet::seek_history( const history_table& history, const uint32_t from )
+{
+    // history ids grow with time, binary search the id range for the first row at or after `from`
+    if ( from == 0 || history.begin() == history.end() ) return 0;
+    uint64_t lo = history.begin()->id;
+    uint64_t hi = history.available_primary_key();
+    while ( lo < hi ) {
+        const uint64_t mid = lo + (hi - lo) / 2;
+        auto itr = history.lower_bound( mid );
+        if ( itr == history.end() || itr->timestamp.sec_since_epoch() >= from ) hi = mid;
+        else lo = itr->id + 1;
+    }
+    return lo;
 }
 
 void faucet::create_account( const name account, const public_key key )
@@ -211,17 +1065,36 @@ void faucet::create_account( const name account, const public_key key )
     eosiosystem::authority owner = {1, keys, {}, {}};
     eosiosystem::native::newaccount_action newaccount( "eosio"_n, { get_self(), "active"_n } );
     eosiosystem::system_contract::buyrambytes_action buyrambytes( "eosio"_n, { get_self(), "active"_n });
-
-    // send assets
-    const asset balance = token::get_balance( TOKEN, get_self(), EOS.code() );
-    check( balance.amount >= QUANTITY.amount + RAM + NET.amount + CPU.amount, "eosio.faucet is empty, please contact administrator");
+    eosiosystem::system_contract::delegatebw_action delegatebw( "eosio"_n, { get_self(), "active"_n });
 
     newaccount.send( get_self(), account, owner, owner );
     buyrambytes.send( get_self(), account, RAM );
+    delegatebw.send( get_self(), account, NET, CPU, false );
+}
+
+uint64_t faucet::add_create_ratelimit( const public_key& key, const uint32_t prune_rows )
+{
+    // expired `create` scope rows are pruned with the watchdog budget (single `by.time` lookup when none expired)
+    const uint64_t pruned = prune_rate_limits( CREATE_SCOPE, prune_rows );
+    add_stats( CREATE_SCOPE, MAX_CREATE_PER_GLOBAL );
+    add_ratelimit( CREATE_SCOPE, to_address( key ), CREATE_COOLDOWN, MAX_CREATE_PER_KEY );
+    return pruned;
+}
+
+asset faucet::get_create_cost( const config_row& config )
+{
+    // cached RAM cost avoids reading the system RAM market
+    return config.ram_cost + NET + CPU;
 }
 
 void faucet::transfer( const name from, const name to, const extended_asset value, const string& memo )
 {
     eosio::token::transfer_action transfer( value.contract, { from, "active"_n });
     transfer.send( from, to, value.quantity, memo );
+}
+
+void faucet::log_send( const string& receiver, const asset& quantity, const name lane, const uint64_t counter )
+{
+    faucet::logsend_action logsend( get_self(), { get_self(), "active"_n });
+    logsend.send( receiver, quantity, lane, counter );
 }
\ No newline at end of file
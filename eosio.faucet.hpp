@@ -4,10 +4,17 @@
 #include <eosio/eosio.hpp>
 #include <eosio/system.hpp>
 #include <eosio/asset.hpp>
-#include <eosio/crypto.hpp>
+#include <eosio/singleton.hpp>
 
+#include <algorithm>
 #include <string>
 
+#include "eosio.faucet.policy.hpp"
+
+#ifndef FAUCET_POLICY
+#define FAUCET_POLICY faucet_policy
+#endif
+
 using namespace eosio;
 using namespace std;
 
@@ -15,34 +22,120 @@ class [[eosio::contract("eosio.faucet")]] faucet : public eosio::contract {
 public:
     using contract::contract;
 
+    // compile-time policy (see `eosio.faucet.policy.hpp`)
+    using policy = FAUCET_POLICY;
+
     // Token Transfer
     const name TOKEN = "eosio.token"_n;
     const symbol EOS = symbol{"EOS", 4};
-    const asset QUANTITY = asset{10000, EOS};           // (1.0000 EOS)
-    const asset QUANTITY_DECREMENT = asset{1000, EOS};  // (0.1 EOS) decrement amount per counter
-    const asset GAS_FEE = asset{100, EOS};              // (0.01 EOS)
-    const string MEMO = "received by https://faucet.testnet.evm.eosnetwork.com";
+    const asset QUANTITY = asset{policy::QUANTITY, EOS};
+    const asset QUANTITY_DECREMENT = asset{policy::QUANTITY_DECREMENT, EOS};
+    const asset GAS_FEE = asset{policy::GAS_FEE, EOS};
+    const string MEMO = policy::MEMO;
 
     // Account creation
-    const asset NET = asset{1'0000, EOS};
-    const asset CPU = asset{1'0000, EOS};
-    const uint32_t RAM = 8000;
+    const asset NET = asset{policy::NET, EOS};
+    const asset CPU = asset{policy::CPU, EOS};
+    const uint32_t RAM = policy::RAM;
 
     // Stats
-    const uint32_t STATS_INTERVAL = 3600;               // 1 hour
+    const uint32_t STATS_INTERVAL = policy::STATS_INTERVAL;
 
     // Data pruning
-    const uint32_t TTL_HISTORY = 86400 * 7;             // 7 days
-    const uint32_t TTL_USER_RATE_LIMIT = 86400;         // 24 hours
+    const uint32_t TTL_HISTORY = policy::TTL_HISTORY;
+    const uint32_t TTL_USER_RATE_LIMIT = policy::TTL_USER_RATE_LIMIT;
+    const uint32_t PRUNE_ROWS = 10;                     // rows pruned per table per action
+    const uint32_t MAX_PRUNE_ROWS = 100;                // maximum rows pruned per table per action under RAM pressure
+
+    // RAM watchdog
+    const uint32_t WATCHDOG_TTL = 3600;                 // (1 hour) RAM reports older than this are ignored
+
+    // Receiver filter (blocked Bloom filter, one shard row read per lookup)
+    // 64 x 1024 bits (8 KiB), false positive rate with 3 probes: ~0.01% at 1k, ~0.9% at 5k, ~5% at 10k entries
+    const uint64_t FILTER_SHARDS = 64;                  // filter rows
+    const uint32_t FILTER_WORDS = 16;                   // 64-bit words per filter row (1024 bits)
+    const uint32_t FILTER_PROBES = 3;                   // hash probes per lookup
+
+    // Claims (bitmap of claimed leaves per round)
+    const uint32_t CLAIM_WORDS = 16;                    // 64-bit words per `claimed` row (1024 leaves)
+
+    // Vouchers
+    const uint32_t MAX_VOUCHER_TTL = 86400;             // (24 hours) maximum voucher expiry, bounds the `nonces` buckets
+    const uint32_t NONCE_PERIOD = 3600;                 // (1 hour) `nonces` expiry bucket
+    const uint32_t NONCE_WORDS = 16;                    // 64-bit words per `nonces` row (1024 nonces)
+
+    // Pacing
+    const int64_t PACING_ONE = 1 << 16;                 // 16.16 fixed-point drip scale
+
+    // Schema
+    const uint16_t SCHEMA_VERSION = 2;                  // current table layout version (`ratelimit.v2`)
+    const uint64_t RATELIMIT_PROBES = 4;                // `ratelimit.v2` keys probed from the address key on collision
+
+    // Maintenance
+    const uint64_t MAINTENANCE_ROWS = 500;              // default rows scanned per `maintain` call
+    const uint32_t COMPACT_INTERVAL = 86400;            // (1 day) stats older than TTL_HISTORY are compacted into `stats.daily` rows
+
+    // Export
+    const uint32_t EXPORT_ROWS = 500;                   // default & maximum rows scanned per `exportrows` page
 
     // Rate limits
-    const uint32_t USER_COOLDOWN = 60;              // (1 minute) user cooldown timer per single faucet event
-    const uint32_t MAX_COUNTER_PER_USER = 10;       // max rate limit per user counters (resests by TTL_USER_RATE_LIMIT)
-    const uint32_t MAX_COUNTER_PER_GLOBAL = 5000;   // max rate limit per global counters (resets by STATS_INTERVAL)
+    const uint32_t USER_COOLDOWN = policy::USER_COOLDOWN;
+    const uint32_t MAX_COUNTER_PER_USER = policy::MAX_COUNTER_PER_USER;
+    const uint32_t MAX_COUNTER_PER_GLOBAL = policy::MAX_COUNTER_PER_GLOBAL;
+
+    // Account creation rate limits
+    const name CREATE_SCOPE = "create"_n;           // `ratelimit` & `stats` scope used by account creation
+    const uint32_t CREATE_COOLDOWN = policy::CREATE_COOLDOWN;
+    const uint32_t MAX_CREATE_PER_KEY = policy::MAX_CREATE_PER_KEY;
+    const uint32_t MAX_CREATE_PER_GLOBAL = policy::MAX_CREATE_PER_GLOBAL;
+
+    /**
+     * ## TABLE `config`
+     *
+     * - `{bool} history` - track receivers in the on-chain `history` table (when disabled, the audit trail relies on `logsend` action traces)
+     * - `{asset} ram_cost` - cached estimate of the cost of `RAM` bytes used by account creation
+     * - `{name} filter` - receiver filter mode (`deny`, `allow` or empty to disable)
+     * - `{bool} soft_reject` - rejected `send` requests are counted in `metrics` and succeed without sending tokens
+     * - `{uint32_t} refill_period` - pacing refill horizon in seconds (0 disables pacing)
+     * - `{time_point_sec} refill_epoch` - pacing refill anchor (refills at `refill_epoch + n * refill_period`)
+     * - `{public_key} [voucher_key]` - public key signing vouchers (empty disables `redeem`)
+     * - `{uint8_t} ram_high` - RAM usage percent above which pruning budget is raised
+     * - `{uint8_t} ram_critical` - RAM usage percent above which degraded mode skips history and only serves returning addresses
+     *
+     * ### example
+     *
+     * ```json
+     * {
+     *     "history": true,
+     *     "ram_cost": "0.5000 EOS",
+     *     "filter": "deny",
+     *     "soft_reject": false,
+     *     "refill_period": 86400,
+     *     "refill_epoch": "2023-04-01T00:00:00",
+     *     "voucher_key": "PUB_K1_7hg8uP17qWQcF4m2L9x2gwGSGA2wiHERJGSgDLXSHcYm96yxmK",
+     *     "ram_high": 80,
+     *     "ram_critical": 95
+     * }
+     * ```
+     */
+    struct [[eosio::table("config")]] config_row {
+        bool                history = true;
+        asset               ram_cost = asset{1'0000, symbol{"EOS", 4}};
+        name                filter;
+        bool                soft_reject = false;
+        uint32_t            refill_period = 0;
+        time_point_sec      refill_epoch;
+        optional<public_key> voucher_key;
+        uint8_t             ram_high = 80;
+        uint8_t             ram_critical = 95;
+    };
+    typedef eosio::singleton< "config"_n, config_row > config_table;
 
     /**
      * ## TABLE `ratelimit`
      *
+     * Scoped by `get_self()` for `send` receivers and by `create` for account creation public keys.
+     *
      * - `{uint64_t} id` - (primary key) incremental key
      * - `{string} to` - receiver account (EOS or EVM)
      * - `{uint64_t} counter` - counter used to rate limit total actions allowed per time
@@ -62,7 +155,7 @@ public:
     struct [[eosio::table("ratelimit")]] ratelimit_row {
         uint64_t            id;
         string              address;
-        uint64_t            counter;
+        uint64_t            counter = 0;
         time_point_sec      last_send_time;
 
         checksum256 by_address() const { return to_checksum(address); }
@@ -78,9 +171,237 @@ public:
         return sha256(address.c_str(), address.length());
     }
 
+    static string to_filter_address( string address )
+    {
+        // EVM addresses are case-insensitive (EIP-55 checksum casing)
+        if ( address.length() > 12 ) {
+            for ( char& c : address ) if ( c >= 'A' && c <= 'Z' ) c += 'a' - 'A';
+        }
+        return address;
+    }
+
+    static uint64_t to_key( const string address )
+    {
+        // first 64 bits of the address checksum
+        const auto hash = to_checksum( address ).extract_as_byte_array();
+        uint64_t key = 0;
+        for ( int i = 0; i < 8; i++ ) key = (key << 8) | hash[i];
+        return key;
+    }
+
+    static bool is_name( const string& value )
+    {
+        // valid characters of an account name (checked before `name{}` which aborts on invalid input)
+        if ( value.empty() || value.length() > 12 ) return false;
+        for ( const char c : value ) {
+            if ( !((c >= 'a' && c <= 'z') || (c >= '1' && c <= '5') || c == '.') ) return false;
+        }
+        return true;
+    }
+
+    static string to_address( const public_key& key )
+    {
+        // public key as hex string, rate limited like a receiver address
+        const char* hex = "0123456789abcdef";
+        const std::vector<char> data = pack( key );
+        string address;
+        for ( const char c : data ) {
+            address += hex[(c >> 4) & 0x0f];
+            address += hex[c & 0x0f];
+        }
+        return address;
+    }
+
+    /**
+     * ## TABLE `filter`
+     *
+     * Blocked Bloom filter of receivers, split into `FILTER_SHARDS` fixed-size rows.
+     *
+     * - `{uint64_t} shard` - (primary key) shard index
+     * - `{vector<uint64_t>} bits` - `FILTER_WORDS` words of filter bits
+     *
+     * ### example
+     *
+     * ```json
+     * {
+     *     "shard": 12,
+     *     "bits": ["0", "9007199254740992", ...]
+     * }
+     * ```
+     */
+    struct [[eosio::table("filter")]] filter_row {
+        uint64_t            shard;
+        std::vector<uint64_t> bits;
+
+        uint64_t primary_key() const { return shard; }
+    };
+    typedef eosio::multi_index< "filter"_n, filter_row > filter_table;
+
+    /**
+     * ## TABLE `ratelimit.v2`
+     *
+     * Compact layout of `ratelimit` (schema version 2), same scopes as `ratelimit`.
+     *
+     * - `{uint64_t} key` - (primary key) first 64 bits of the address checksum, next free key on collision
+     * - `{string} address` - receiver account (EOS or EVM) or public key
+     * - `{uint32_t} counter` - counter used to rate limit total actions allowed per time
+     * - `{time_point_sec} last_send_time` - last send (secondary index used for pruning)
+     *
+     * ### example
+     *
+     * ```json
+     * {
+     *     "key": "12282010479376541893",
+     *     "address": "aa2F34E41B397aD905e2f48059338522D05CA534",
+     *     "counter": 10,
+     *     "last_send_time": "2022-07-24T00:00:00"
+     * }
+     * ```
+     */
+    struct [[eosio::table("ratelimit.v2")]] ratelimit_v2_row {
+        uint64_t            key;
+        string              address;
+        uint32_t            counter = 0;
+        time_point_sec      last_send_time;
+
+        uint64_t primary_key() const { return key; }
+        uint64_t by_time() const { return last_send_time.sec_since_epoch(); }
+    };
+    typedef eosio::multi_index< "ratelimit.v2"_n, ratelimit_v2_row,
+        indexed_by<"by.time"_n, const_mem_fun<ratelimit_v2_row, uint64_t, &ratelimit_v2_row::by_time>>
+    > ratelimit_v2_table;
+
+    /**
+     * ## TABLE `rounds`
+     *
+     * - `{name} round` - (primary key) claim round
+     * - `{checksum256} root` - Merkle root of `sha256(pack(index, receiver, quantity))` leaves
+     * - `{uint64_t} leaves` - total leaves of the round
+     *
+     * ### example
+     *
+     * ```json
+     * {
+     *     "round": "hackathon1",
+     *     "root": "1c6e3b0fa4d1c2d9f0b2f31a2d8b1e4a3c7d6e5f4a3b2c1d0e9f8a7b6c5d4e3f",
+     *     "leaves": 5000
+     * }
+     * ```
+     */
+    struct [[eosio::table("rounds")]] round_row {
+        name                round;
+        checksum256         root;
+        uint64_t            leaves;
+
+        uint64_t primary_key() const { return round.value; }
+    };
+    typedef eosio::multi_index< "rounds"_n, round_row > rounds_table;
+
+    /**
+     * ## TABLE `claimed`
+     *
+     * Scoped by claim round, bitmap of claimed leaves split into `CLAIM_WORDS` words per row.
+     *
+     * - `{uint64_t} chunk` - (primary key) leaf index / (64 * `CLAIM_WORDS`)
+     * - `{vector<uint64_t>} bits` - claimed leaves bitmap
+     *
+     * ### example
+     *
+     * ```json
+     * {
+     *     "chunk": 0,
+     *     "bits": ["18446744073709551615", "3", ...]
+     * }
+     * ```
+     */
+    struct [[eosio::table("claimed")]] claimed_row {
+        uint64_t            chunk;
+        std::vector<uint64_t> bits;
+
+        uint64_t primary_key() const { return chunk; }
+    };
+    typedef eosio::multi_index< "claimed"_n, claimed_row > claimed_table;
+
+    /**
+     * ## TABLE `nonces`
+     *
+     * Scoped by voucher expiry bucket (`expiry / NONCE_PERIOD`), bitmap of redeemed nonces split into `NONCE_WORDS` words per row.
+     * Buckets are dropped as a whole once every voucher of the bucket has expired (expired vouchers are rejected).
+     *
+     * - `{uint64_t} chunk` - (primary key) nonce / (64 * `NONCE_WORDS`)
+     * - `{vector<uint64_t>} bits` - redeemed nonces bitmap
+     *
+     * ### example
+     *
+     * ```json
+     * {
+     *     "chunk": 0,
+     *     "bits": ["18446744073709551615", "3", ...]
+     * }
+     * ```
+     */
+    struct [[eosio::table("nonces")]] nonces_row {
+        uint64_t            chunk;
+        std::vector<uint64_t> bits;
+
+        uint64_t primary_key() const { return chunk; }
+    };
+    typedef eosio::multi_index< "nonces"_n, nonces_row > nonces_table;
+
+    /**
+     * ## TABLE `nonce.bucket`
+     *
+     * Expiry buckets holding `nonces` rows, oldest bucket is pruned first.
+     *
+     * - `{uint64_t} bucket` - (primary key) voucher expiry / `NONCE_PERIOD`
+     *
+     * ### example
+     *
+     * ```json
+     * {
+     *     "bucket": 466753
+     * }
+     * ```
+     */
+    struct [[eosio::table("nonce.bucket")]] nonce_bucket_row {
+        uint64_t            bucket;
+
+        uint64_t primary_key() const { return bucket; }
+    };
+    typedef eosio::multi_index< "nonce.bucket"_n, nonce_bucket_row > nonce_buckets_table;
+
+    /**
+     * ## TABLE `schema`
+     *
+     * - `{uint16_t} version` - active table layout version
+     * - `{bool} migrating` - legacy rows remain to be migrated (reads fall back to legacy tables)
+     *
+     * ### example
+     *
+     * ```json
+     * {
+     *     "version": 2,
+     *     "migrating": true
+     * }
+     * ```
+     */
+    struct [[eosio::table("schema")]] schema_row {
+        uint16_t            version = 1;
+        bool                migrating = false;
+    };
+    typedef eosio::singleton< "schema"_n, schema_row > schema_table;
+
+    struct migrate_result {
+        uint16_t            version;
+        uint64_t            migrated;
+        bool                done;
+    };
+
     /**
      * ## TABLE `stats`
      *
+     * Scoped by `get_self()` for `send` and by `create` for account creation.
+     *
      * - `{time_point_sec} timestamp` - timestamp for the stats
      * - `{uint64_t} counter` - counter total send transactions
      *
@@ -95,12 +416,116 @@ public:
      */
     struct [[eosio::table("stats")]] stats_row {
         time_point_sec      timestamp;
-        uint64_t            counter;
+        uint64_t            counter = 0;
 
         uint64_t primary_key() const { return timestamp.sec_since_epoch(); }
     };
     typedef eosio::multi_index< "stats"_n, stats_row> stats_table;
 
+    /**
+     * ## TABLE `stats.daily`
+     *
+     * Daily totals of `stats` rows older than `TTL_HISTORY`, written by `maintain` (`compact` operation), same scopes as `stats`.
+     *
+     * - `{time_point_sec} timestamp` - start of the day
+     * - `{uint64_t} counter` - counter total send transactions of the day
+     *
+     * ### example
+     *
+     * ```json
+     * {
+     *     "timestamp": "2022-07-24T00:00:00",
+     *     "counter": 240,
+     * }
+     * ```
+     */
+    struct [[eosio::table("stats.daily")]] stats_daily_row {
+        time_point_sec      timestamp;
+        uint64_t            counter = 0;
+
+        uint64_t primary_key() const { return timestamp.sec_since_epoch(); }
+    };
+    typedef eosio::multi_index< "stats.daily"_n, stats_daily_row> stats_daily_table;
+
+    /**
+     * ## TABLE `metrics`
+     *
+     * - `{uint64_t} sends_native` - tokens sent to EOS accounts
+     * - `{uint64_t} sends_evm` - tokens sent to EVM addresses
+     * - `{uint64_t} rejected_cooldown` - rejected by user cooldown
+     * - `{uint64_t} rejected_user_max` - rejected by per user maximum
+     * - `{uint64_t} rejected_global_max` - rejected by global maximum
+     * - `{uint64_t} rejected_empty` - rejected by empty faucet
+     * - `{uint64_t} rejected_address` - rejected by invalid address
+     * - `{uint64_t} rejected_filter` - rejected by receiver filter
+     * - `{uint64_t} rejected_degraded` - rejected new addresses in degraded (low RAM) mode
+     * - `{uint64_t} pruned` - `history` & `ratelimit` rows pruned
+     * - `{uint64_t} rejected_paced` - rejected by a drip paced down to zero
+     * - `{uint64_t} pruned_nonces` - expired voucher `nonces` rows pruned
+     *
+     * Rejections are only counted in soft reject mode (failed transactions roll back state).
+     *
+     * ### example
+     *
+     * ```json
+     * {
+     *     "sends_native": 1200,
+     *     "sends_evm": 3400,
+     *     "rejected_cooldown": 50,
+     *     "rejected_user_max": 20,
+     *     "rejected_global_max": 0,
+     *     "rejected_empty": 0,
+     *     "rejected_address": 3,
+     *     "rejected_filter": 12,
+     *     "rejected_degraded": 0,
+     *     "pruned": 4000,
+     *     "rejected_paced": 0,
+     *     "pruned_nonces": 300
+     * }
+     * ```
+     */
+    struct [[eosio::table("metrics")]] metrics_row {
+        uint64_t            sends_native = 0;
+        uint64_t            sends_evm = 0;
+        uint64_t            rejected_cooldown = 0;
+        uint64_t            rejected_user_max = 0;
+        uint64_t            rejected_global_max = 0;
+        uint64_t            rejected_empty = 0;
+        uint64_t            rejected_address = 0;
+        uint64_t            rejected_filter = 0;
+        uint64_t            rejected_degraded = 0;
+        uint64_t            pruned = 0;
+        uint64_t            rejected_paced = 0;
+        uint64_t            pruned_nonces = 0;
+    };
+    typedef eosio::singleton< "metrics"_n, metrics_row > metrics_table;
+
+    /**
+     * ## TABLE `watchdog`
+     *
+     * RAM usage of the contract account, reported by an off-chain monitor (`get_resource_limits` is a privileged intrinsic).
+     *
+     * - `{int64_t} ram_usage` - RAM bytes used
+     * - `{int64_t} ram_quota` - RAM bytes quota
+     * - `{time_point_sec} updated` - last report
+     *
+     * ### example
+     *
+     * ```json
+     * {
+     *     "ram_usage": 7340032,
+     *     "ram_quota": 8388608,
+     *     "updated": "2023-04-01T00:00:00"
+     * }
+     * ```
+     */
+    struct [[eosio::table("watchdog")]] watchdog_row {
+        int64_t             ram_usage = 0;
+        int64_t             ram_quota = 0;
+        time_point_sec      updated;
+    };
+    typedef eosio::singleton< "watchdog"_n, watchdog_row > watchdog_table;
+
     /**
      * ## TABLE `history`
      *
@@ -126,6 +551,58 @@ public:
     };
     typedef eosio::multi_index< "history"_n, history_row > history_table;
 
+    /**
+     * ## TABLE `cursor`
+     *
+     * Scoped by maintained table name (`ratelimit`, `ratelimit.v2`, `history`, `stats`, `stats.daily` or `claimed`).
+     *
+     * - `{name} scope` - (primary key) maintained table scope
+     * - `{name} op` - maintenance operation in progress
+     * - `{string} prefix` - address prefix used by `prefix` operation
+     * - `{uint64_t} next` - next primary key to scan
+     * - `{uint64_t} scanned` - total rows scanned by the operation
+     * - `{uint64_t} erased` - total rows erased (or compacted) by the operation
+     *
+     * ### example
+     *
+     * ```json
+     * {
+     *     "scope": "eosio.faucet",
+     *     "op": "expired",
+     *     "prefix": "",
+     *     "next": 1500,
+     *     "scanned": 1500,
+     *     "erased": 1200
+     * }
+     * ```
+     */
+    struct [[eosio::table("cursor")]] cursor_row {
+        name                scope;
+        name                op;
+        string              prefix;
+        uint64_t            next = 0;
+        uint64_t            scanned = 0;
+        uint64_t            erased = 0;
+
+        uint64_t primary_key() const { return scope.value; }
+    };
+    typedef eosio::multi_index< "cursor"_n, cursor_row > cursor_table;
+
+    struct maintain_result {
+        name                op;
+        uint64_t            next;
+        uint64_t            scanned;
+        uint64_t            erased;
+        bool                done;
+    };
+
+    struct export_result {
+        std::vector<char>   rows;
+        uint64_t            cursor;
+        uint32_t            count;
+        bool                more;
+    };
+
     /**
      * ## ACTION `send`
      *
@@ -155,6 +632,10 @@ public:
      *
      * > Create account using {{key}} as active & owner permission.
      *
+     * Buys `RAM` bytes and stakes `NET` & `CPU` so the new account can transact right away.
+     * Rate limited per public key and per global interval (one `stats` row & one `ratelimit` row of the `create` scope),
+     * expired `create` scope rows are pruned with the RAM watchdog budget.
+     *
      * - **authority**: `get_self()`
      *
      * ### params
@@ -165,39 +646,556 @@ public:
      * ### Example
      *
      * ```bash
-     * $ cleos push action eosio.faucet create '[myaccount, "EOS5uHeBsURAT6bBXNtvwKtWaiDSDJSdSmc96rHVws5M1qqVCkAm6"]' -p anyaccount
+     * $ cleos push action eosio.faucet create '[myaccount, "EOS5uHeBsURAT6bBXNtvwKtWaiDSDJSdSmc96rHVws5M1qqVCkAm6"]' -p eosio.faucet
      * ```
      */
     [[eosio::action]]
     void create( const name account, const public_key key );
 
-    // @debug
+    /**
+     * ## ACTION `createsend`
+     *
+     * > Create account using {{key}} as active & owner permission and send tokens to {{account}}.
+     *
+     * Combines `create` & `send` in a single action, sharing the funding check and the rate limit entry.
+     *
+     * - **authority**: `get_self()`
+     *
+     * ### params
+     *
+     * - `{name} account` - account to be created
+     * - `{public_key} key` - EOSIO public key to be used as active/owner permission
+     *
+     * ### Example
+     *
+     * ```bash
+     * $ cleos push action eosio.faucet createsend '[myaccount, "EOS5uHeBsURAT6bBXNtvwKtWaiDSDJSdSmc96rHVws5M1qqVCkAm6"]' -p eosio.faucet
+     * ```
+     */
     [[eosio::action]]
-    void test( const string address );
+    void createsend( const name account, const public_key key );
 
-    // @debug
+    /**
+     * ## ACTION `sethistory`
+     *
+     * > Enable or disable the on-chain `history` table.
+     *
+     * When disabled, `send` stops writing `history` rows and drains the existing table in bounded chunks.
+     * Policies without `HISTORY` always drain the table and only accept `false`.
+     *
+     * - **authority**: `get_self()`
+     *
+     * ### params
+     *
+     * - `{bool} enabled` - track receivers in the `history` table
+     *
+     * ### Example
+     *
+     * ```bash
+     * $ cleos push action eosio.faucet sethistory '[false]' -p eosio.faucet
+     * ```
+     */
     [[eosio::action]]
-    void cleartable( const name table_name, const optional<name> scope, const optional<uint64_t> max_rows );
+    void sethistory( const bool enabled );
 
-    // action wrappers
-    using send_action = eosio::action_wrapper<"send"_n, &faucet::send>;
-
-private :
-    // debug
-    template <typename T>
-    void clear_table( T& table, uint64_t rows_to_clear );
+    /**
+     * ## ACTION `setramcost`
+     *
+     * > Set the cached cost estimate of `RAM` bytes purchased by account creation.
+     *
+     * Used by `create` to check funding in a single comparison without reading the system RAM market.
+     *
+     * - **authority**: `get_self()`
+     *
+     * ### params
+     *
+     * - `{asset} ram_cost` - estimated cost of `RAM` bytes
+     *
+     * ### Example
+     *
+     * ```bash
+     * $ cleos push action eosio.faucet setramcost '["0.5000 EOS"]' -p eosio.faucet
+     * ```
+     */
+    [[eosio::action]]
+    void setramcost( const asset ram_cost );
 
-    void create_account( const name account, const public_key key );
+    /**
+     * ## ACTION `setfilter`
+     *
+     * > Set receiver filter mode to {{mode}}.
+     *
+     * `send` & `createsend` check the receiver against the `filter` table before any table write.
+     *
+     * - **authority**: `get_self()`
+     *
+     * ### params
+     *
+     * - `{name} mode` - `deny` (reject listed receivers), `allow` (reject unlisted receivers) or empty to disable
+     *
+     * ### Example
+     *
+     * ```bash
+     * $ cleos push action eosio.faucet setfilter '["deny"]' -p eosio.faucet
+     * ```
+     */
+    [[eosio::action]]
+    void setfilter( const name mode );
+
+    /**
+     * ## ACTION `filteradd`
+     *
+     * > Add receivers to the receiver filter.
+     *
+     * EVM addresses are matched case-insensitively.
+     *
+     * - **authority**: `get_self()`
+     *
+     * ### params
+     *
+     * - `{vector<string>} addresses` - receiver accounts (EOS or EVM)
+     *
+     * ### Example
+     *
+     * ```bash
+     * $ cleos push action eosio.faucet filteradd '[["badaccount", "0xaa2F34E41B397aD905e2f48059338522D05CA534"]]' -p eosio.faucet
+     * ```
+     */
+    [[eosio::action]]
+    void filteradd( const std::vector<string> addresses );
+
+    /**
+     * ## ACTION `filterclear`
+     *
+     * > Remove all receivers from the receiver filter.
+     *
+     * - **authority**: `get_self()`
+     *
+     * ### Example
+     *
+     * ```bash
+     * $ cleos push action eosio.faucet filterclear '[]' -p eosio.faucet
+     * ```
+     */
+    [[eosio::action]]
+    void filterclear();
+
+    /**
+     * ## ACTION `setpacing`
+     *
+     * > Pace drips to spend the balance evenly until the next refill.
+     *
+     * The drip amount is scaled down so the remaining balance, split per `STATS_INTERVAL` until the next refill,
+     * covers the recent request rate measured in `stats`. A drip paced down to zero is rejected (`paced` reason).
+     *
+     * - **authority**: `get_self()`
+     *
+     * ### params
+     *
+     * - `{uint32_t} refill_period` - refill horizon in seconds (0 disables pacing)
+     * - `{time_point_sec} refill_epoch` - refill anchor
+     *
+     * ### Example
+     *
+     * ```bash
+     * $ cleos push action eosio.faucet setpacing '[86400, "2023-04-01T00:00:00"]' -p eosio.faucet
+     * ```
+     */
+    [[eosio::action]]
+    void setpacing( const uint32_t refill_period, const time_point_sec refill_epoch );
+
+    /**
+     * ## ACTION `setsoftrej`
+     *
+     * > Enable or disable soft reject mode.
+     *
+     * In soft reject mode, rejected `send` requests are counted in `metrics` by reason
+     * and the transaction succeeds without sending tokens.
+     *
+     * - **authority**: `get_self()`
+     *
+     * ### params
+     *
+     * - `{bool} enabled` - soft reject mode
+     *
+     * ### Example
+     *
+     * ```bash
+     * $ cleos push action eosio.faucet setsoftrej '[true]' -p eosio.faucet
+     * ```
+     */
+    [[eosio::action]]
+    void setsoftrej( const bool enabled );
+
+    /**
+     * ## ACTION `getmetrics`
+     *
+     * > Get operational metrics.
+     *
+     * - **authority**: none (read-only)
+     *
+     * ### Example
+     *
+     * ```bash
+     * $ cleos push action eosio.faucet getmetrics '[]' -p anyaccount --read-only
+     * ```
+     */
+    [[eosio::action, eosio::read_only]]
+    metrics_row getmetrics();
+
+    /**
+     * ## ACTION `ramreport`
+     *
+     * > Report RAM usage of the contract account.
+     *
+     * Pushed periodically by a monitor (e.g. from `get_account`), reports older than `WATCHDOG_TTL` are ignored.
+     *
+     * - **authority**: `get_self()`
+     *
+     * ### params
+     *
+     * - `{int64_t} ram_usage` - RAM bytes used
+     * - `{int64_t} ram_quota` - RAM bytes quota
+     *
+     * ### Example
+     *
+     * ```bash
+     * $ cleos push action eosio.faucet ramreport '[7340032, 8388608]' -p eosio.faucet
+     * ```
+     */
+    [[eosio::action]]
+    void ramreport( const int64_t ram_usage, const int64_t ram_quota );
+
+    /**
+     * ## ACTION `setwatermark`
+     *
+     * > Set RAM usage watermarks.
+     *
+     * Above `ram_high`, pruning budget grows by `PRUNE_ROWS` per percent (up to `MAX_PRUNE_ROWS`),
+     * above `ram_critical`, `send` skips history and only serves returning addresses, account creation, `claim` & `redeem` are rejected.
+     *
+     * - **authority**: `get_self()`
+     *
+     * ### params
+     *
+     * - `{uint8_t} ram_high` - high watermark (percent)
+     * - `{uint8_t} ram_critical` - critical watermark (percent, 1 to 100)
+     *
+     * ### Example
+     *
+     * ```bash
+     * $ cleos push action eosio.faucet setwatermark '[80, 95]' -p eosio.faucet
+     * ```
+     */
+    [[eosio::action]]
+    void setwatermark( const uint8_t ram_high, const uint8_t ram_critical );
+
+    /**
+     * ## ACTION `logsend`
+     *
+     * > Log {{quantity}} sent to {{receiver}} receiver account.
+     *
+     * Inline notification emitted by every payout, indexers can read a single action trace per payout
+     * instead of tracking `history`, `ratelimit` & `stats` table deltas.
+     *
+     * - **authority**: `get_self()`
+     *
+     * ### params
+     *
+     * - `{string} receiver` - receiver account (EOS or EVM)
+     * - `{asset} quantity` - quantity sent (including EVM gas fee)
+     * - `{name} lane` - payout lane (`native` or `evm` drips, `claim` for Merkle claims, `redeem` for vouchers)
+     * - `{uint64_t} counter` - receiver rate limit counter after the payout (0 when the payout is not rate limited)
+     *
+     * ### Example
+     *
+     * ```json
+     * {
+     *     "receiver": "myaccount",
+     *     "quantity": "1.0000 EOS",
+     *     "lane": "native",
+     *     "counter": 1
+     * }
+     * ```
+     */
+    [[eosio::action]]
+    void logsend( const string receiver, const asset quantity, const name lane, const uint64_t counter );
+
+    /**
+     * ## ACTION `setround`
+     *
+     * > Publish Merkle root of {{round}} claim round.
+     *
+     * Rejected when {{round}} already exists or its claimed bitmap is not cleared by `delround`.
+     *
+     * - **authority**: `get_self()`
+     *
+     * ### params
+     *
+     * - `{name} round` - claim round
+     * - `{checksum256} root` - Merkle root of `sha256(pack(index, receiver, quantity))` leaves
+     * - `{uint64_t} leaves` - total leaves of the round
+     *
+     * ### Example
+     *
+     * ```bash
+     * $ cleos push action eosio.faucet setround '["hackathon1", "1c6e3b0fa4d1c2d9f0b2f31a2d8b1e4a3c7d6e5f4a3b2c1d0e9f8a7b6c5d4e3f", 5000]' -p eosio.faucet
+     * ```
+     */
+    [[eosio::action]]
+    void setround( const name round, const checksum256 root, const uint64_t leaves );
+
+    /**
+     * ## ACTION `delround`
+     *
+     * > Delete {{round}} claim round.
+     *
+     * Closes the round and erases up to `MAINTENANCE_ROWS` claimed bitmap rows per call,
+     * call again until the bitmap is cleared before publishing {{round}} again.
+     *
+     * - **authority**: `get_self()`
+     *
+     * ### params
+     *
+     * - `{name} round` - claim round
+     *
+     * ### Example
+     *
+     * ```bash
+     * $ cleos push action eosio.faucet delround '["hackathon1"]' -p eosio.faucet
+     * ```
+     */
+    [[eosio::action]]
+    void delround( const name round );
+
+    /**
+     * ## ACTION `claim`
+     *
+     * > Claim {{quantity}} to {{receiver}} from {{round}} claim round.
+     *
+     * The leaf `sha256(pack(index, receiver, quantity))` is verified against the round Merkle root,
+     * each proof node is hashed on the left when the matching bit of `index` is set (right otherwise).
+     *
+     * - **authority**: any
+     *
+     * ### params
+     *
+     * - `{name} round` - claim round
+     * - `{uint64_t} index` - leaf index
+     * - `{string} receiver` - receiver account (EOS or EVM)
+     * - `{asset} quantity` - leaf quantity
+     * - `{vector<checksum256>} proof` - Merkle proof (leaf to root)
+     *
+     * ### Example
+     *
+     * ```bash
+     * $ cleos push action eosio.faucet claim '["hackathon1", 42, "myaccount", "5.0000 EOS", ["...", "..."]]' -p anyaccount
+     * ```
+     */
+    [[eosio::action]]
+    void claim( const name round, const uint64_t index, const string receiver, const asset quantity, const std::vector<checksum256> proof );
+
+    /**
+     * ## ACTION `setvoucher`
+     *
+     * > Set public key signing vouchers.
+     *
+     * Use a distinct key per network, vouchers are only bound to the faucet account.
+     *
+     * - **authority**: `get_self()`
+     *
+     * ### params
+     *
+     * - `{public_key} [key]` - public key signing vouchers (null disables `redeem`)
+     *
+     * ### Example
+     *
+     * ```bash
+     * $ cleos push action eosio.faucet setvoucher '["PUB_K1_7hg8uP17qWQcF4m2L9x2gwGSGA2wiHERJGSgDLXSHcYm96yxmK"]' -p eosio.faucet
+     * ```
+     */
+    [[eosio::action]]
+    void setvoucher( const optional<public_key> key );
+
+    /**
+     * ## ACTION `redeem`
+     *
+     * > Redeem voucher of {{quantity}} to {{receiver}}.
+     *
+     * The voucher is signed off-chain by `voucher_key` over `sha256(pack(get_self(), receiver, quantity, expiry, nonce))`,
+     * any account can push it (no relayer required). Each nonce can only be redeemed once per expiry bucket,
+     * issue nonces sequentially so each `nonces` bitmap row covers 1024 vouchers.
+     *
+     * - **authority**: any
+     *
+     * ### params
+     *
+     * - `{string} receiver` - receiver account (EOS or EVM)
+     * - `{asset} quantity` - voucher quantity
+     * - `{time_point_sec} expiry` - voucher expiry (at most `MAX_VOUCHER_TTL` ahead)
+     * - `{uint64_t} nonce` - voucher nonce
+     * - `{signature} sig` - voucher signature
+     *
+     * ### Example
+     *
+     * ```bash
+     * $ cleos push action eosio.faucet redeem '["myaccount", "1.0000 EOS", "2023-04-01T01:00:00", 123456789, "SIG_K1_..."]' -p anyaccount
+     * ```
+     */
+    [[eosio::action]]
+    void redeem( const string receiver, const asset quantity, const time_point_sec expiry, const uint64_t nonce, const signature sig );
+
+    /**
+     * ## ACTION `migrate`
+     *
+     * > Migrate tables to the current schema version.
+     *
+     * The first call switches writes to the new layout, legacy rows are then moved in bounded chunks
+     * (or on the next write of the same address by the hot path) until the legacy tables are empty.
+     * Reads fall back to the legacy row while migrating and never move it.
+     *
+     * - **authority**: `get_self()`
+     *
+     * ### params
+     *
+     * - `{uint64_t} max_rows` - maximum rows migrated (default `MAINTENANCE_ROWS` when 0)
+     *
+     * ### Example
+     *
+     * ```bash
+     * $ cleos push action eosio.faucet migrate '[1000]' -p eosio.faucet
+     * ```
+     */
+    [[eosio::action]]
+    migrate_result migrate( const uint64_t max_rows );
+
+    /**
+     * ## ACTION `exportrows`
+     *
+     * > Export a page of {{table_name}} rows.
+     *
+     * Read-only, returns `count` rows packed back to back in the table binary (ABI) layout,
+     * along with an opaque `cursor` used to resume the export when `more` is true.
+     * Time range filters `history.timestamp`, `stats.timestamp` or `ratelimit.last_send_time`,
+     * `history`, `stats` & `stats.daily` pages seek to `from` (binary search of the time-ordered `history` ids).
+     *
+     * - **authority**: none (read-only)
+     *
+     * ### params
+     *
+     * - `{name} table_name` - table to export (`ratelimit`, `ratelimit.v2`, `history`, `stats` or `stats.daily`)
+     * - `{name} [scope]` - table scope (default `get_self()`)
+     * - `{uint64_t} cursor` - resume cursor returned by the previous page (0 for first page)
+     * - `{time_point_sec} [from]` - include rows at or after timestamp
+     * - `{time_point_sec} [to]` - include rows at or before timestamp
+     * - `{uint32_t} limit` - maximum rows scanned (default & maximum `EXPORT_ROWS`)
+     *
+     * ### Example
+     *
+     * ```bash
+     * $ cleos push action eosio.faucet exportrows '["history", null, 0, "2023-04-01T00:00:00", "2023-04-02T00:00:00", 500]' -p anyaccount --read-only
+     * ```
+     */
+    [[eosio::action, eosio::read_only]]
+    export_result exportrows( const name table_name, const optional<name> scope, const uint64_t cursor, const optional<time_point_sec> from, const optional<time_point_sec> to, const uint32_t limit );
+
+    // @debug
+    [[eosio::action]]
+    void test( const string address );
+
+    /**
+     * ## ACTION `maintain`
+     *
+     * > Run {{op}} maintenance operation on {{table_name}} table.
+     *
+     * Resumes from the persisted `cursor` of the table scope, scans at most `max_rows` rows per call
+     * and returns the exact progress of the operation (cursor is removed once done).
+     *
+     * - **authority**: `get_self()`
+     *
+     * ### params
+     *
+     * - `{name} table_name` - table to maintain (`ratelimit`, `ratelimit.v2`, `history`, `stats`, `stats.daily` or `claimed`)
+     * - `{name} op` - operation
+     *   - `all` - erase all rows of the scope (only operation of `stats.daily` & `claimed`)
+     *   - `expired` - erase rows past their TTL
+     *   - `prefix` - erase rows where address starts with `prefix` (`ratelimit`, `ratelimit.v2` & `history`)
+     *   - `compact` - move hourly rows older than `TTL_HISTORY` into `stats.daily` rows of the same scope (`stats`)
+     * - `{name} [scope]` - table scope (default `get_self()`)
+     * - `{string} [prefix]` - address prefix used by `prefix` operation
+     * - `{uint64_t} [max_rows]` - maximum rows scanned (default `MAINTENANCE_ROWS`)
+     *
+     * ### Example
+     *
+     * ```bash
+     * $ cleos push action eosio.faucet maintain '["history", "expired", null, null, 1000]' -p eosio.faucet
+     * $ cleos push action eosio.faucet maintain '["ratelimit", "prefix", null, "0xaa2F", null]' -p eosio.faucet
+     * ```
+     */
+    [[eosio::action]]
+    maintain_result maintain( const name table_name, const name op, const optional<name> scope, const optional<string> prefix, const optional<uint64_t> max_rows );
+
+    // action wrappers
+    using send_action = eosio::action_wrapper<"send"_n, &faucet::send>;
+    using logsend_action = eosio::action_wrapper<"logsend"_n, &faucet::logsend>;
+
+private :
+    // maintenance
+    template <typename T, typename F>
+    bool erase_rows( T& table, cursor_row& cursor, uint64_t max_rows, F predicate );
+    bool compact_stats( stats_table& stats, stats_daily_table& daily, cursor_row& cursor, uint64_t max_rows );
+
+    // claims
+    void check_address( const string& address );
+    checksum256 hash_pair( const checksum256& left, const checksum256& right );
+
+    // vouchers
+    uint64_t prune_nonces();
+
+    // export
+    template <typename T, typename F, typename P>
+    export_result export_rows( const T& table, const uint64_t cursor, const uint32_t limit, F in_range, P is_past );
+    uint64_t seek_history( const history_table& history, const uint32_t from );
+
+    void create_account( const name account, const public_key key );
+    uint64_t add_create_ratelimit( const public_key& key, const uint32_t prune_rows );
+    asset get_create_cost( const config_row& config );
+
+    config_row get_config();
+
+    // receiver filter
+    bool is_filtered( const config_row& config, const string& address );
+    bool filter_contains( const string& address );
+    uint64_t filter_shard( const std::array<uint8_t, 32>& hash );
+    uint32_t filter_bit( const std::array<uint8_t, 32>& hash, const uint32_t probe );
+
+    // schema
+    optional<schema_row> _schema;
+    schema_row get_schema();
+    void migrate_ratelimit( ratelimit_v2_table& ratelimit, const ratelimit_row& row );
+    optional<ratelimit_v2_row> find_ratelimit( const ratelimit_v2_table& ratelimit, const string& address );
+    bool migrate_ratelimits( const name scope, uint64_t& max_rows );
 
     void transfer( const name from, const name to, const extended_asset value, const string& memo );
+    void log_send( const string& receiver, const asset& quantity, const name lane, const uint64_t counter );
 
-    void send_eos( const string address );
-    void send_eos_evm( const string address );
-    void send_eos_native( const string address );
-    uint64_t add_ratelimit( const string address );
+    void send_eos( const string address, const asset quantity, const uint64_t counter, const name lane = name{} );
+    uint64_t add_ratelimit( const name scope, const string address, const uint32_t cooldown, const uint64_t max_counter );
+    ratelimit_v2_row get_ratelimit( const name scope, const string& address );
+    void set_ratelimit( const name scope, const ratelimit_v2_row& limit, const uint64_t counter );
     void add_history( const string address );
-    void prune_rate_limits();
-    void prune_rate_limit( const string address );
-    void prune_history();
-    void add_stats();
+    uint64_t track_history( const config_row& config, const string& address, const bool degraded, const uint32_t prune_rows );
+    uint64_t prune_rate_limits( const name scope, const uint32_t max_rows );
+    uint64_t prune_history( const bool enabled, const uint32_t max_rows );
+    uint64_t get_stats( const name scope, const uint32_t intervals_ago );
+    asset get_paced_quantity( const config_row& config, const asset quantity, const asset balance, const uint64_t requests );
+    void add_stats( const name scope, const uint64_t max_counter );
+
+    // metrics
+    bool admit( const config_row& config, const bool condition, const name reason, const string& message );
+    void add_metrics( const name lane, const uint64_t pruned, const uint64_t pruned_nonces = 0 );
+
+    // RAM watchdog
+    uint32_t get_ram_usage();
+    uint32_t get_prune_rows( const config_row& config, const uint32_t ram_usage );
 };
\ No newline at end of file
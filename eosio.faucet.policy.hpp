@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+
+/**
+ * ## POLICY `faucet_policy`
+ *
+ * Compile-time constants & feature toggles of the faucet, one policy per network.
+ *
+ * Select the policy at build time with `-DFAUCET_POLICY=<policy>` (default `faucet_policy`),
+ * branches of disabled features are compiled out of the WASM.
+ *
+ * ```bash
+ * $ cdt-cpp eosio.faucet.cpp -I include -DFAUCET_POLICY=native_policy -o eosio.faucet.native.wasm
+ * ```
+ */
+struct faucet_policy {
+    // Token Transfer
+    static constexpr int64_t QUANTITY = 1'0000;                 // (1.0000 EOS)
+    static constexpr int64_t QUANTITY_DECREMENT = 1000;         // (0.1 EOS) decrement amount per counter
+    static constexpr int64_t GAS_FEE = 100;                     // (0.01 EOS)
+    static constexpr const char* MEMO = "received by https://faucet.testnet.evm.eosnetwork.com";
+
+    // Account creation
+    static constexpr int64_t NET = 1'0000;                      // (1.0000 EOS)
+    static constexpr int64_t CPU = 1'0000;                      // (1.0000 EOS)
+    static constexpr uint32_t RAM = 8000;                       // bytes
+
+    // Stats
+    static constexpr uint32_t STATS_INTERVAL = 3600;            // 1 hour
+
+    // Data pruning
+    static constexpr uint32_t TTL_HISTORY = 86400 * 7;          // 7 days
+    static constexpr uint32_t TTL_USER_RATE_LIMIT = 86400;      // 24 hours
+
+    // Rate limits
+    static constexpr uint32_t USER_COOLDOWN = 60;               // (1 minute) user cooldown timer per single faucet event
+    static constexpr uint32_t MAX_COUNTER_PER_USER = 10;        // max rate limit per user counters (resests by TTL_USER_RATE_LIMIT)
+    static constexpr uint32_t MAX_COUNTER_PER_GLOBAL = 5000;    // max rate limit per global counters (resets by STATS_INTERVAL)
+
+    // Account creation rate limits
+    static constexpr uint32_t CREATE_COOLDOWN = 3600;           // (1 hour) public key cooldown timer per account creation
+    static constexpr uint32_t MAX_CREATE_PER_KEY = 5;           // max account creations per public key (resets by TTL_USER_RATE_LIMIT)
+    static constexpr uint32_t MAX_CREATE_PER_GLOBAL = 500;      // max account creations per global counters (resets by STATS_INTERVAL)
+
+    // Features
+    static constexpr bool HISTORY = true;                       // on-chain `history` table
+    static constexpr bool EVM = true;                           // send tokens to EVM addresses
+};
+
+/**
+ * ## POLICY `native_policy`
+ *
+ * Native-only testnet: no EVM, audit trail from `logsend` action traces instead of the `history` table
+ * (rows left by a previous build are drained in bounded chunks by `send`).
+ */
+struct native_policy : faucet_policy {
+    static constexpr int64_t QUANTITY = 10'0000;                // (10.0000 EOS)
+    static constexpr int64_t QUANTITY_DECREMENT = 1'0000;       // (1.0000 EOS) decrement amount per counter
+    static constexpr const char* MEMO = "received by eosio.faucet";
+
+    static constexpr bool HISTORY = false;
+    static constexpr bool EVM = false;
+};
@@ -1,4 +1,4 @@
-import { TimePointSec, Name } from "@greymass/eosio";
+import { TimePointSec, Name, Asset, Checksum256, PrivateKey, Serializer, UInt64 } from "@greymass/eosio";
 import { Blockchain } from "@proton/vert"
 import { it, describe, beforeEach } from "node:test";
 import assert from 'node:assert';
@@ -8,30 +8,493 @@ const blockchain = new Blockchain()
 
 // contracts
 const contract = blockchain.createContract('eosio.faucet', 'eosio.faucet', true);
+const token = blockchain.createContract('eosio.token', 'include/eosio.token/eosio.token', true);
 
-blockchain.createAccounts('myaccount', 'anyaccount');
+blockchain.createAccounts('myaccount', 'anyaccount', 'legacy1', 'legacy2', 'newaccount1', 'newaccount2', 'softrej1', 'softrej2', 'softrej3', 'pacinga', 'pacingb', 'pacingc', 'pacingd', 'pacinge', 'pacingf', 'pacingg', 'pacingh', 'pacingi', 'pacingj', 'pacingk', 'pacingz', 'degraded1', 'degraded2');
 
 // one-time setup
 beforeEach(async () => {
   blockchain.setTime(TimePointSec.from("2023-04-01T00:00:00.000"));
 });
 
+async function setup_token() {
+  await token.actions.create(["eosio", "10000000000.0000 EOS"]).send("eosio.token");
+  await token.actions.issue(["eosio", "10000000000.0000 EOS", ""]).send("eosio");
+  await token.actions.transfer(["eosio", "eosio.faucet", "1000000.0000 EOS", ""]).send("eosio");
+}
+
+function set_time(seconds) {
+  blockchain.setTime(TimePointSec.fromMilliseconds(Date.parse("2023-04-01T00:00:00.000Z") + seconds * 1000));
+}
+
+function get_balance(account) {
+  const scope = Name.from(account).value.value;
+  const row = token.tables.accounts(scope).getTableRows()[0];
+  return row ? row.balance : "0.0000 EOS";
+}
+
+function concat(...arrays) {
+  return Uint8Array.from(arrays.flatMap(array => Array.from(array)));
+}
+
+// leaf = sha256(pack(index, receiver, quantity))
+function merkle_leaf(index, receiver, quantity) {
+  return Checksum256.hash(concat(
+    Serializer.encode({object: UInt64.from(index)}).array,
+    Serializer.encode({object: receiver, type: 'string'}).array,
+    Serializer.encode({object: Asset.from(quantity)}).array,
+  ));
+}
+
+function merkle_pair(left, right) {
+  return Checksum256.hash(concat(left.array, right.array));
+}
+
+// returns root & proofs (leaf to root) of a power of two number of leaves
+function merkle_tree(leaves) {
+  let level = leaves.map(([receiver, quantity], index) => merkle_leaf(index, receiver, quantity));
+  const proofs = leaves.map(() => []);
+  let positions = leaves.map((_, index) => index);
+  while ( level.length > 1 ) {
+    positions.forEach((position, index) => proofs[index].push(level[position ^ 1].toString()));
+    const next = [];
+    for ( let i = 0; i < level.length; i += 2 ) next.push(merkle_pair(level[i], level[i + 1]));
+    level = next;
+    positions = positions.map(position => position >> 1);
+  }
+  return { root: level[0].toString(), proofs };
+}
+
+// sig = sign(sha256(pack(get_self(), receiver, quantity, expiry, nonce)))
+function sign_voucher(key, receiver, quantity, expiry, nonce) {
+  const digest = Checksum256.hash(concat(
+    Serializer.encode({object: Name.from("eosio.faucet")}).array,
+    Serializer.encode({object: receiver, type: 'string'}).array,
+    Serializer.encode({object: Asset.from(quantity)}).array,
+    Serializer.encode({object: TimePointSec.from(expiry)}).array,
+    Serializer.encode({object: UInt64.from(nonce)}).array,
+  ));
+  return key.signDigest(digest).toString();
+}
+
 function get_history(id) {
   const scope = Name.from('eosio.faucet').value.value;
-  return contract.tables.devices(scope).getTableRow(BigInt(id));
+  return contract.tables.history(scope).getTableRow(BigInt(id));
+}
+
+function get_ratelimits(table) {
+  const scope = Name.from('eosio.faucet').value.value;
+  return contract.tables[table](scope).getTableRows();
 }
 
 describe('eosio.faucet', () => {
 
-  // it("send", async () => {
-  //   await contract.actions.send(["myaccount"]).send("anyaccount");
-  //   assert.deepEqual(get_history(1).receiver, "myaccount");
-  // });
+  it("setup", async () => {
+    await setup_token();
+    assert.equal(get_balance("eosio.faucet"), "1000000.0000 EOS");
+  });
+
+  it("ratelimit: legacy rows are read during migration", async () => {
+    await contract.actions.send(["legacy1"]).send("anyaccount");
+    await contract.actions.send(["legacy2"]).send("anyaccount");
+    assert.equal(get_ratelimits("ratelimit").length, 2);
+
+    // migrate a single row, `legacy2` stays in the legacy table
+    await contract.actions.migrate([1]).send("eosio.faucet");
+    assert.deepEqual(get_ratelimits("ratelimit").map(row => row.address), ["legacy2"]);
+
+    // cooldown is enforced from the legacy row
+    set_time(30);
+    await expectToThrow(contract.actions.send(["legacy2"]).send("anyaccount"), /eosio.faucet must wait/);
+
+    // next write moves the legacy row with its counter
+    set_time(120);
+    await contract.actions.send(["legacy2"]).send("anyaccount");
+    assert.equal(get_ratelimits("ratelimit").length, 0);
+    const row = get_ratelimits("ratelimit.v2").find(row => row.address == "legacy2");
+    assert.equal(row.counter, 2);
+  });
+
+  it("filter: EVM addresses are denied regardless of case", async () => {
+    await contract.actions.setfilter(["deny"]).send("eosio.faucet");
+    await contract.actions.filteradd([["0xaa2f34e41b397ad905e2f48059338522d05ca534"]]).send("eosio.faucet");
+
+    for ( const address of ["0xaa2f34e41b397ad905e2f48059338522d05ca534", "0xaa2F34E41B397aD905e2f48059338522D05CA534", "0xAA2F34E41B397AD905E2F48059338522D05CA534"] ) {
+      await expectToThrow(contract.actions.send([address]).send("anyaccount"), /eosio.faucet \[address\] is not allowed/);
+    }
+    await contract.actions.filterclear([]).send("eosio.faucet");
+    await contract.actions.setfilter([""]).send("eosio.faucet");
+  });
+
+  describe("claim", () => {
+    const leaves = [["myaccount", "1.0000 EOS"], ["anyaccount", "2.0000 EOS"], ["legacy1", "3.0000 EOS"], ["legacy2", "4.0000 EOS"]];
+    const { root, proofs } = merkle_tree(leaves);
+
+    it("setround", async () => {
+      await contract.actions.setround(["round1", root, leaves.length]).send("eosio.faucet");
+      await expectToThrow(contract.actions.setround(["round1", root, leaves.length]).send("eosio.faucet"), /eosio.faucet \[round\] already exists/);
+    });
+
+    it("proof nodes are hashed on the left for set index bits", async () => {
+      // index 1 (left sibling at level 0) & index 2 (left sibling at level 1)
+      const before = Asset.from(get_balance("anyaccount"));
+      await contract.actions.claim(["round1", 1, "anyaccount", "2.0000 EOS", proofs[1]]).send("anyaccount");
+      assert.equal(Asset.from(get_balance("anyaccount")).units.toNumber() - before.units.toNumber(), 2_0000);
+      await contract.actions.claim(["round1", 2, "legacy1", "3.0000 EOS", proofs[2]]).send("anyaccount");
+    });
+
+    it("error: swapped proof order", async () => {
+      const swapped = [...proofs[0]].reverse();
+      await expectToThrow(contract.actions.claim(["round1", 0, "myaccount", "1.0000 EOS", swapped]).send("anyaccount"), /eosio.faucet \[proof\] is invalid/);
+    });
+
+    it("error: proof is bound to the leaf index", async () => {
+      await expectToThrow(contract.actions.claim(["round1", 3, "myaccount", "1.0000 EOS", proofs[0]]).send("anyaccount"), /eosio.faucet \[proof\] is invalid/);
+    });
+
+    it("error: double claim", async () => {
+      await contract.actions.claim(["round1", 0, "myaccount", "1.0000 EOS", proofs[0]]).send("anyaccount");
+      await expectToThrow(contract.actions.claim(["round1", 0, "myaccount", "1.0000 EOS", proofs[0]]).send("anyaccount"), /eosio.faucet \[index\] has already been claimed/);
+    });
+
+    it("delround clears the bitmap before the round is reused", async () => {
+      await contract.actions.delround(["round1"]).send("eosio.faucet");
+      const scope = Name.from("round1").value.value;
+      assert.equal(contract.tables.claimed(scope).getTableRows().length, 0);
+
+      await contract.actions.setround(["round1", root, leaves.length]).send("eosio.faucet");
+      await contract.actions.claim(["round1", 0, "myaccount", "1.0000 EOS", proofs[0]]).send("anyaccount");
+    });
+  });
+
+  describe("redeem", () => {
+    const key = PrivateKey.generate("K1");
+    const expiry = "2023-04-01T01:00:00";
+
+    it("error: vouchers are disabled", async () => {
+      const sig = sign_voucher(key, "myaccount", "1.0000 EOS", expiry, 1);
+      await expectToThrow(contract.actions.redeem(["myaccount", "1.0000 EOS", expiry, 1, sig]).send("anyaccount"), /eosio.faucet vouchers are disabled/);
+    });
+
+    it("redeem voucher signed by the voucher key", async () => {
+      await contract.actions.setvoucher([key.toPublic().toString()]).send("eosio.faucet");
+      const before = Asset.from(get_balance("myaccount"));
+      const sig = sign_voucher(key, "myaccount", "1.0000 EOS", expiry, 1);
+      await contract.actions.redeem(["myaccount", "1.0000 EOS", expiry, 1, sig]).send("anyaccount");
+      assert.equal(Asset.from(get_balance("myaccount")).units.toNumber() - before.units.toNumber(), 1_0000);
+    });
+
+    it("error: nonce replay", async () => {
+      const sig = sign_voucher(key, "myaccount", "1.0000 EOS", expiry, 1);
+      await expectToThrow(contract.actions.redeem(["myaccount", "1.0000 EOS", expiry, 1, sig]).send("anyaccount"), /eosio.faucet \[nonce\] voucher has already been redeemed/);
+    });
+
+    it("error: voucher fields are bound to the signature", async () => {
+      const sig = sign_voucher(key, "myaccount", "1.0000 EOS", expiry, 2);
+      await expectToThrow(contract.actions.redeem(["myaccount", "9.0000 EOS", expiry, 2, sig]).send("anyaccount"), /eosio.faucet \[sig\] invalid voucher signature/);
+      await expectToThrow(contract.actions.redeem(["anyaccount", "1.0000 EOS", expiry, 2, sig]).send("anyaccount"), /eosio.faucet \[sig\] invalid voucher signature/);
+    });
+
+    it("error: voucher signed by another key", async () => {
+      const sig = sign_voucher(PrivateKey.generate("K1"), "myaccount", "1.0000 EOS", expiry, 3);
+      await expectToThrow(contract.actions.redeem(["myaccount", "1.0000 EOS", expiry, 3, sig]).send("anyaccount"), /eosio.faucet \[sig\] invalid voucher signature/);
+    });
+
+    it("error: expired voucher", async () => {
+      set_time(7200);
+      const sig = sign_voucher(key, "myaccount", "1.0000 EOS", expiry, 4);
+      await expectToThrow(contract.actions.redeem(["myaccount", "1.0000 EOS", expiry, 4, sig]).send("anyaccount"), /eosio.faucet \[expiry\] voucher has expired/);
+    });
+
+    it("expired nonce buckets are dropped", async () => {
+      const bucket = BigInt(Date.parse(expiry + "Z") / 1000 / 3600);
+      assert.equal(contract.tables.nonces(bucket).getTableRows().length, 1);
+
+      // next redeem after the bucket expired drops its bitmap rows
+      set_time(7200);
+      const next = "2023-04-01T03:00:00";
+      await contract.actions.redeem(["myaccount", "1.0000 EOS", next, 5, sign_voucher(key, "myaccount", "1.0000 EOS", next, 5)]).send("anyaccount");
+      assert.equal(contract.tables.nonces(bucket).getTableRows().length, 0);
+      const buckets = contract.tables["nonce.bucket"](Name.from("eosio.faucet").value.value).getTableRows();
+      assert.deepEqual(buckets.map(row => BigInt(row.bucket)), [BigInt(Date.parse(next + "Z") / 1000 / 3600)]);
+    });
+  });
+
+  describe("createsend", () => {
+    // Vert has no system contract, the account stands in for the one created by the `newaccount` inline action
+    const key = PrivateKey.generate("K1").toPublic().toString();
 
-  // it("error: account does not exists", async () => {
-  //   const action = contract.actions.send(["invalid"]).send();
-  //   await expectToThrow(action, /faucet::send: [to] account does not exist/);
-  // });
+    it("error: single funding check covers account creation & drip", async () => {
+      await contract.actions.setramcost(["1000000.0000 EOS"]).send("eosio.faucet");
+      await expectToThrow(contract.actions.createsend(["newaccount1", key]).send("eosio.faucet"), /eosio.faucet is empty/);
+      await contract.actions.setramcost(["1.0000 EOS"]).send("eosio.faucet");
+    });
+
+    it("error: requires contract authority", async () => {
+      await expectToThrow(contract.actions.createsend(["newaccount1", key]).send("anyaccount"), /missing required authority/);
+    });
+
+    it("createsend", async () => {
+      await contract.actions.createsend(["newaccount1", key]).send("eosio.faucet");
+      assert.equal(get_balance("newaccount1"), "1.0000 EOS");
+
+      // single rate limit row per scope (receiver & public key)
+      assert.equal(get_ratelimits("ratelimit.v2").filter(row => row.address == "newaccount1").length, 1);
+      assert.equal(contract.tables["ratelimit.v2"](Name.from("create").value.value).getTableRows().length, 1);
+    });
+  });
+
+  it("createsend: expired create scope rows are pruned", async () => {
+    set_time(86400 + 3600);
+    const key = PrivateKey.generate("K1").toPublic().toString();
+    await contract.actions.createsend(["newaccount2", key]).send("eosio.faucet");
+
+    // row of the previous public key is past TTL_USER_RATE_LIMIT
+    const rows = contract.tables["ratelimit.v2"](Name.from("create").value.value).getTableRows();
+    assert.equal(rows.length, 1);
+    assert.equal(rows[0].counter, 1);
+  });
+
+  describe("maintain", () => {
+    const cursor = table => contract.tables.cursor(Name.from(table).value.value).getTableRows();
+    const self = Name.from("eosio.faucet").value.value;
+
+    it("cursor resumes across calls", async () => {
+      await contract.actions.maintain(["history", "prefix", null, "legacy", 1]).send("eosio.faucet");
+      const [row] = cursor("history");
+      assert.equal(row.op, "prefix");
+      assert.equal(row.scanned, 1);
+      assert.equal(row.erased, 1);
+
+      await contract.actions.maintain(["history", "prefix", null, "legacy", 1]).send("eosio.faucet");
+      assert.equal(cursor("history")[0].scanned, 2);
+    });
+
+    it("different operation resets the cursor", async () => {
+      await contract.actions.maintain(["history", "expired", null, null, 1]).send("eosio.faucet");
+      const [row] = cursor("history");
+      assert.equal(row.op, "expired");
+      assert.equal(row.scanned, 1);
+      assert.equal(row.erased, 0);
+
+      // different prefix restarts the scan as well
+      await contract.actions.maintain(["history", "prefix", null, "legacy", 1000]).send("eosio.faucet");
+      assert.equal(cursor("history").length, 0);
+      const history = contract.tables.history(self).getTableRows();
+      assert.equal(history.filter(row => row.receiver.startsWith("legacy")).length, 0);
+    });
+
+    it("compact moves old hourly stats into stats.daily", async () => {
+      set_time(86400 * 9);
+      const expected = {};
+      for ( const row of contract.tables.stats(self).getTableRows() ) {
+        const day = row.timestamp.slice(0, 10) + "T00:00:00";
+        expected[day] = (expected[day] ?? 0) + Number(row.counter);
+      }
+
+      // one row per call, cursor resumes until every row older than TTL_HISTORY is moved
+      await contract.actions.maintain(["stats", "compact", null, null, 1]).send("eosio.faucet");
+      assert.equal(cursor("stats").length, 1);
+      for ( let i = 0; i < 50 && cursor("stats").length; i++ ) {
+        await contract.actions.maintain(["stats", "compact", null, null, 1]).send("eosio.faucet");
+      }
+      assert.equal(contract.tables.stats(self).getTableRows().length, 0);
+
+      const daily = contract.tables["stats.daily"](self).getTableRows();
+      assert.deepEqual(Object.fromEntries(daily.map(row => [row.timestamp, Number(row.counter)])), expected);
+    });
+  });
+
+  it("send", async () => {
+    await contract.actions.send(["myaccount"]).send("anyaccount");
+    const scope = Name.from('eosio.faucet').value.value;
+    const last = contract.tables.history(scope).getTableRows().at(-1);
+    assert.deepEqual(get_history(last.id).receiver, "myaccount");
+  });
+
+  it("error: account does not exist", async () => {
+    await expectToThrow(contract.actions.send(["invalid"]).send("anyaccount"), /invalid account does not exist/);
+    // invalid name characters are rejected by `is_name` before `name{}`
+    await expectToThrow(contract.actions.send(["Invalid_Name"]).send("anyaccount"), /Invalid_Name account does not exist/);
+  });
+
+  describe("soft reject", () => {
+    const self = Name.from("eosio.faucet").value.value;
+    const metrics = () => contract.tables.metrics(self).getTableRows()[0] ?? {};
+    const snapshot = () => ({
+      balance: get_balance("eosio.faucet"),
+      ratelimits: get_ratelimits("ratelimit.v2").length,
+      history: contract.tables.history(self).getTableRows().length,
+    });
+
+    // rejected in soft mode: no transfer or table writes, only the metrics counter
+    async function expect_soft_reject(to, counter, message) {
+      await contract.actions.setsoftrej([false]).send("eosio.faucet");
+      await expectToThrow(contract.actions.send([to]).send("anyaccount"), message);
+
+      await contract.actions.setsoftrej([true]).send("eosio.faucet");
+      const before = snapshot();
+      const rejected = Number(metrics()[counter] ?? 0);
+      await contract.actions.send([to]).send("anyaccount");
+      assert.deepEqual(snapshot(), before);
+      assert.equal(Number(metrics()[counter]), rejected + 1);
+      await contract.actions.setsoftrej([false]).send("eosio.faucet");
+    }
+
+    it("filter", async () => {
+      await contract.actions.setfilter(["deny"]).send("eosio.faucet");
+      await contract.actions.filteradd([["softrej1"]]).send("eosio.faucet");
+      await expect_soft_reject("softrej1", "rejected_filter", /eosio.faucet \[address\] is not allowed/);
+      await contract.actions.filterclear([]).send("eosio.faucet");
+      await contract.actions.setfilter([""]).send("eosio.faucet");
+    });
+
+    it("address", async () => {
+      await expect_soft_reject("Invalid_Name", "rejected_address", /Invalid_Name account does not exist/);
+    });
+
+    it("cooldown", async () => {
+      await contract.actions.send(["softrej1"]).send("anyaccount");
+      await expect_soft_reject("softrej1", "rejected_cooldown", /eosio.faucet must wait 60 seconds/);
+    });
+
+    it("usermax", async () => {
+      for ( let i = 0; i < 10; i++ ) {
+        set_time(i * 61);
+        await contract.actions.send(["softrej2"]).send("anyaccount");
+      }
+      set_time(10 * 61);
+      await expect_soft_reject("softrej2", "rejected_user_max", /eosio.faucet address has received the maximum allocation of tokens/);
+    });
+
+    it("degraded", async () => {
+      await contract.actions.ramreport([95, 100]).send("eosio.faucet");
+      await expect_soft_reject("softrej3", "rejected_degraded", /eosio.faucet is low on RAM, only returning addresses are served/);
+      await contract.actions.ramreport([0, 100]).send("eosio.faucet");
+    });
+
+    it("empty", async () => {
+      // drain the faucet with a voucher, then refund it
+      const key = PrivateKey.generate("K1");
+      const balance = get_balance("eosio.faucet");
+      await contract.actions.setvoucher([key.toPublic().toString()]).send("eosio.faucet");
+      await contract.actions.redeem(["softrej3", balance, "2023-04-01T01:00:00", 1000, sign_voucher(key, "softrej3", balance, "2023-04-01T01:00:00", 1000)]).send("anyaccount");
+
+      await expect_soft_reject("softrej3", "rejected_empty", /eosio.faucet is empty, please contact administrator/);
+      await token.actions.transfer(["softrej3", "eosio.faucet", balance, ""]).send("softrej3");
+    });
+  });
+
+  describe("pacing", () => {
+    const key = PrivateKey.generate("K1");
+    const day = 86400 * 30;
+    let nonce = 5000;
+
+    const units = account => Asset.from(get_balance(account)).units.toNumber();
+    const timestamp = seconds => TimePointSec.fromMilliseconds(Date.parse("2023-04-01T00:00:00.000Z") + seconds * 1000).toString();
+
+    // exact faucet balance: withdraw with a voucher or top up from the issuer
+    async function set_faucet_balance(amount, now) {
+      const current = units("eosio.faucet");
+      const quantity = Asset.fromUnits(Math.abs(current - amount), "4,EOS").toString();
+      if ( current > amount ) {
+        const expiry = timestamp(now + 3600);
+        nonce++;
+        await contract.actions.redeem(["pacingz", quantity, expiry, nonce, sign_voucher(key, "pacingz", quantity, expiry, nonce)]).send("anyaccount");
+      }
+      if ( current < amount ) await token.actions.transfer(["eosio", "eosio.faucet", quantity, ""]).send("eosio");
+      assert.equal(units("eosio.faucet"), amount);
+    }
+
+    async function expect_paid(to, amount) {
+      const before = units(to);
+      await contract.actions.send([to]).send("anyaccount");
+      assert.equal(units(to) - before, amount);
+    }
+
+    it("setup", async () => {
+      await contract.actions.setvoucher([key.toPublic().toString()]).send("eosio.faucet");
+      await contract.actions.setpacing([86400, "2023-04-01T00:00:00"]).send("eosio.faucet");
+    });
+
+    it("scale is capped at the configured drip", async () => {
+      // 24 intervals, demand 1: budget 41666 > QUANTITY
+      set_time(day);
+      await set_faucet_balance(1_000_000, day);
+      await expect_paid("pacinga", 1_0000);
+    });
+
+    it("remaining intervals are rounded up", async () => {
+      // 81000s until refill = 22.5 intervals -> 23, previous interval demand 1
+      set_time(day + 5400);
+      await set_faucet_balance(23 * 5000, day + 5400);
+      await expect_paid("pacingb", 5000);
+      await contract.actions.send(["pacingc"]).send("anyaccount");
+      await contract.actions.send(["pacingd"]).send("anyaccount");
+    });
+
+    it("demand is the previous interval when higher", async () => {
+      // 77400s -> 22 intervals, demand max(current 0, previous 3)
+      set_time(day + 9000);
+      await set_faucet_balance(22 * 3 * 5000, day + 9000);
+      await expect_paid("pacinge", 5000);
+      for ( const to of ["pacingf", "pacingg", "pacingh"] ) await contract.actions.send([to]).send("anyaccount");
+    });
+
+    it("demand is the current interval when higher", async () => {
+      // 77300s -> 22 intervals, demand max(current 4, previous 3)
+      set_time(day + 9100);
+      await set_faucet_balance(22 * 4 * 5000, day + 9100);
+      await expect_paid("pacingi", 5000);
+    });
+
+    it("epoch in the future paces over a full period", async () => {
+      // epoch > now: 24 intervals, budget 3333 -> scale 21843 / 65536 -> drip 3332 (rounded down)
+      await contract.actions.setpacing([86400, timestamp(day + 86400 * 10)]).send("eosio.faucet");
+      set_time(day + 36000);
+      await set_faucet_balance(24 * 3333, day + 36000);
+      await expect_paid("pacingj", 3332);
+    });
+
+    it("error: drip paced down to zero", async () => {
+      // budget 1 -> scale 6 / 65536 -> drip 0, balance is not empty
+      set_time(day + 36000);
+      await set_faucet_balance(24, day + 36000);
+      await expectToThrow(contract.actions.send(["pacingk"]).send("anyaccount"), /eosio.faucet drip is paced to zero/);
+
+      await contract.actions.setsoftrej([true]).send("eosio.faucet");
+      await contract.actions.send(["pacingk"]).send("anyaccount");
+      assert.equal(Number(contract.tables.metrics(Name.from("eosio.faucet").value.value).getTableRows()[0].rejected_paced), 1);
+      await contract.actions.setsoftrej([false]).send("eosio.faucet");
+    });
+
+    it("teardown", async () => {
+      await contract.actions.setpacing([0, "2023-04-01T00:00:00"]).send("eosio.faucet");
+      await set_faucet_balance(1_000_000_0000, 0);
+    });
+  });
+
+  it("degraded: only returning addresses are served above ram_critical", async () => {
+    const self = Name.from("eosio.faucet").value.value;
+    await contract.actions.send(["degraded1"]).send("anyaccount");
+
+    set_time(120);
+    await contract.actions.setwatermark([50, 60]).send("eosio.faucet");
+    await contract.actions.ramreport([60, 100]).send("eosio.faucet");
+
+    // returning address is served without a `history` row
+    const history = contract.tables.history(self).getTableRows().length;
+    await contract.actions.send(["degraded1"]).send("anyaccount");
+    assert.equal(get_balance("degraded1"), "1.9000 EOS");
+    assert.equal(contract.tables.history(self).getTableRows().length, history);
+
+    await expectToThrow(contract.actions.send(["degraded2"]).send("anyaccount"), /eosio.faucet is low on RAM, only returning addresses are served/);
+    const key = PrivateKey.generate("K1").toPublic().toString();
+    await expectToThrow(contract.actions.createsend(["degraded2", key]).send("eosio.faucet"), /eosio.faucet is low on RAM, account creation is paused/);
+
+    await contract.actions.setwatermark([80, 95]).send("eosio.faucet");
+    await contract.actions.ramreport([0, 100]).send("eosio.faucet");
+  });
 });
 
 /**
@@ -47,4 +510,4 @@ const expectToThrow = async (promise, errorMsg) => {
     if ( errorMsg ) assert.match(e.message, errorMsg);
     else assert.fail('Expected promise to throw an error');
   }
-}
\ No newline at end of file
+}